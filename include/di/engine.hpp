@@ -2,63 +2,224 @@
 #define DI_ENGINE_HPP_
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
+#include <di/utility/flight_recorder.hpp>
+#include <di/utility/frame_arena.hpp>
+#include <di/utility/frame_limiter.hpp>
 #include <di/utility/frame_timer.hpp>
+#include <di/utility/job_system.hpp>
+#include <di/utility/signal.hpp>
+#include <di/utility/task_graph.hpp>
+#include <di/utility/thread_pool.hpp>
+#include <di/utility/timer_wheel.hpp>
+#include <di/utility/timing_histogram.hpp>
+#include <di/utility/trace_recorder.hpp>
+#include <di/utility/tsc_clock.hpp>
+#include <di/utility/type_id.hpp>
+#include <di/event_bus.hpp>
+#include <di/frame_scheduler.hpp>
+#include <di/frame_task.hpp>
+#include <di/phase.hpp>
 #include <di/system.hpp>
+#include <di/system_hook.hpp>
+#include <di/system_traits.hpp>
 
 namespace di
 {
 class engine
 {
 public:
+  using duration = frame_timer<float, std::milli>::duration;
+
+  // Blocks the idle engine until platform events arrive or interrupt() is called from any thread, at most for the given timeout.
+  // Typically SDL_WaitEventTimeout, interrupted by pushing an event.
+  struct idle_source
+  {
+    std::function<void(std::chrono::milliseconds)> wait     ;
+    std::function<void()>                          interrupt;
+  };
+
+  // Startup cost of a system: its constructor (on the thread which ran it) and its initialize().
+  struct startup_timing
+  {
+    std::string_view         name          ;
+    std::chrono::nanoseconds construction  {0};
+    std::chrono::nanoseconds initialization{0};
+  };
+
+  // While the engine runs, add_system() and remove_system() may be called from any thread. The changes are then queued and applied in
+  // order at the end of the frame, initializing added and terminating removed systems. An added system is constructed immediately but
+  // becomes visible to get_system() and takes part in the frame from the next frame on.
+  template<typename system_type, typename... system_arguments>
+  system_type* add_system         (system_arguments&&... arguments)
+  {
+    static_assert(std::is_base_of<system, system_type>::value, "The type does not inherit from system.");
+    const auto start  = std::chrono::steady_clock::now();
+    auto       system = std::make_unique<system_type>(arguments...);
+    system->construction_time_ = std::chrono::steady_clock::now() - start;
+    const auto pointer = system.get();
+    if (defers_changes_)
+      enqueue(change {std::move(system), type_id<system_type, di::system>(), type_name<system_type>(), overridden_hooks<system_type>()});
+    else
+      attach (std::move(system), type_id<system_type, di::system>(), type_name<system_type>(), overridden_hooks<system_type>(), systems_.size() + deferred_systems_.size());
+    return pointer;
+  }
+  // Defers the construction of the system to run(), which constructs all deferred systems concurrently and joins them before the first
+  // frame, keeping their position in the order of addition. Systems for which constructs_on_main_thread holds are constructed on the
+  // calling thread, in order. get_system() returns null for the system until then. The arguments are copied.
   template<typename system_type, typename... system_arguments>
-  system_type* add_system   (system_arguments&&... arguments)
+  void         add_deferred_system(system_arguments&&... arguments)
   {
     static_assert(std::is_base_of<system, system_type>::value, "The type does not inherit from system.");
-    auto system = std::make_unique<system_type>(arguments...);
-    system->engine_ = this;
-    systems_.push_back(std::move(system));
-    return static_cast<system_type*>(systems_.back().get());
+    deferred_systems_.push_back(deferred_system
+    {
+      systems_.size() + deferred_systems_.size(),
+      type_id  <system_type, di::system>(),
+      type_name<system_type>(),
+      overridden_hooks<system_type>(),
+      constructs_on_main_thread<system_type>::value,
+      [arguments = std::make_tuple(arguments...)] ()
+      {
+        return std::apply([] (const auto&... arguments) -> std::unique_ptr<system> { return std::make_unique<system_type>(arguments...); }, arguments);
+      }
+    });
   }
   template<typename system_type>
-  system_type* get_system   ()
+  system_type* get_system         ()
   {
     static_assert(std::is_base_of<system, system_type>::value, "The type does not inherit from system.");
-    auto   iterator = std::find_if(systems_.begin(), systems_.end(), system_match_predicate<system_type>);
-    return iterator != systems_.end() ? static_cast<system_type*>(iterator->get()) : nullptr;
+    const auto id = type_id<system_type, di::system>();
+    return id < slots_.size() ? static_cast<system_type*>(slots_[id]) : nullptr;
   }
   template<typename system_type>
-  void         remove_system()
+  void         remove_system      ()
   {
     static_assert(std::is_base_of<system, system_type>::value, "The type does not inherit from system.");
-    systems_.erase(std::remove_if(systems_.begin(), systems_.end(), &system_match_predicate<system_type>), systems_.end());
+    if (defers_changes_)
+      enqueue(change {nullptr, type_id<system_type, di::system>(), std::string_view(), 0});
+    else
+      detach (type_id<system_type, di::system>());
   }
 
   void run       ()
   {
     if (is_running_) return;
-    is_running_ = true;
+    is_running_       = true;
+    defers_changes_   = true;
+    flight_recording_ = flight_recorder_.enabled();
 
-    for (auto& system : systems_)
-      system->initialize();
+    trace_recorder_.set_thread_name("main");
+    scheduler_.set_signal_handler([this] { if (idle_mode_) wake(); });
+    if (worker_count_ > 0)
+      thread_pool_ = std::make_unique<thread_pool>(worker_count_, pin_workers_);
+    jobs_.set_thread_pool(thread_pool_.get());
+    try
+    {
+      start_up();
+    }
+    catch (...)
+    {
+      jobs_.set_thread_pool(nullptr);
+      thread_pool_.reset();
+      is_running_     = false;
+      defers_changes_ = false;
+      throw;
+    }
 
-    frame_timer_.tick();
+    frame_timer_  .tick ();
+    frame_timer_  .reset_statistics();
+    frame_limiter_.reset();
+    frame_latency_.clear();
+    job_wait_     .clear();
+    jobs_         .take_wait_ticks();
+    accumulator_  = accumulator::zero();
+    frame_index_  = 0;
+    step_index_   = 0;
+    elapsed_time_ = accumulator::zero();
+    for (auto& system : systems_)
+      reset_tick_rate(*system, tick_rate_time(*system));
+    frame_starts_  .assign(pipeline_depth_, 0);
+    interpolations_.assign(pipeline_depth_, 0.0F);
+    if (flight_recording_)
+    {
+      flight_recorder_.clear();
+      flight_channels_ = {{flight_recorder_.channel("engine/job wait"), flight_recorder_.channel("engine/frame memory"), flight_recorder_.channel("engine/frame memory overflows")}};
+      frame_overflows_ = frame_arena_.overflow_count();
+    }
     while (is_running_)
     {
+      trace_scope frame_scope(&trace_recorder_, "frame", "engine");
+      const auto  frame_start = tsc_clock::ticks();
+      if (flight_recording_)
+        flight_recorder_.begin_frame(frame_index_);
+      frame_arena_.reset();
+      frame_starts_[frame_index_ % pipeline_depth_] = frame_start;
       frame_timer_.tick();
-      for (auto& system : systems_)
-        system->pre_tick ();
-      for(auto& system : systems_)
-        system->tick     ();
-      for (auto& system : systems_)
-        system->post_tick();
+      elapsed_time_ += frame_timer_.delta_time();
+      scheduler_  .begin_frame();
+      if (fixed_time_step_ == duration::zero() || pipeline_depth_ > 1)
+        timers_.advance(frame_timer_.delta_time());
+      if (pipeline_depth_ > 1)
+        run_pipelined();
+      else if (fixed_time_step_ == duration::zero())
+      {
+        for (auto& system : systems_)
+        {
+          system->delta_time_  = frame_timer_.delta_time();
+          system->frame_index_ = frame_index_;
+        }
+        update_tick_rates(rated_simulation_systems_, frame_index_, elapsed_time_);
+        update_tick_rates(rated_render_systems_    , frame_index_, elapsed_time_);
+        run_schedules(schedules_, true);
+      }
+      else
+        run_fixed_step();
+      if (frame_index_ + 1 >= pipeline_depth_)
+        frame_latency_.record(std::chrono::nanoseconds(tsc_clock::ticks() - frame_starts_[(frame_index_ + 1 - pipeline_depth_) % pipeline_depth_]));
+      const auto job_wait = jobs_.take_wait_ticks();
+      job_wait_.record(std::chrono::nanoseconds(job_wait));
+      ++frame_index_;
+      if (changes_pending_.load(std::memory_order_acquire))
+        apply_changes(true);
+      if (flight_recording_)
+        record_flight(job_wait, frame_start);
+      if (idle_mode_)
+        idle();
+      frame_limiter_.wait();
     }
 
     for (auto& system : systems_)
-      system->terminate();
+      if (system->overrides(system_hook::terminate))
+        system->terminate();
+    defers_changes_ = false;
+    apply_changes(false); // Changes requested by terminate hooks take effect for the next run.
+
+    jobs_.set_thread_pool(nullptr);
+    thread_pool_.reset();
+
+    if (flight_recording_)
+      flight_recorder_.flush();
+    if (!trace_recorder_.exit_filename().empty())
+      trace_recorder_.write(trace_recorder_.exit_filename());
   }
   void stop      ()
   {
@@ -69,16 +230,829 @@ public:
     return is_running_;
   }
 
-protected:
+  // Zero worker threads (default) runs the systems serially on the calling thread. Takes effect on the next call to run().
+  void        set_worker_count(const std::size_t worker_count)
+  {
+    worker_count_ = worker_count;
+  }
+  std::size_t worker_count    () const
+  {
+    return worker_count_;
+  }
+  // Adds a custom phase, run right after the given (built-in or custom) phase wherever the phases run: each frame, fixed step or pipeline
+  // stage. Systems take part through add_phase_hook(name, function), ordered, traced and flight recorded like the built-in phases, but
+  // without system_timings; frame tasks await them with after_phase(). Adding an existing name returns its phase. Takes effect when the schedules are next
+  // built, i.e. on the next call to run() or after the next change of the systems. Call from the thread calling run().
+  di::phase   add_phase       (const std::string& name, const di::phase after)
+  {
+    const auto existing = std::find(phase_names_.begin(), phase_names_.end(), name);
+    if (existing != phase_names_.end())
+      return static_cast<di::phase>(built_in_phase_count + static_cast<std::size_t>(existing - phase_names_.begin()));
+    const auto position = std::find(phase_order_.begin(), phase_order_.end(), after);
+    if (position == phase_order_.end())
+      throw std::runtime_error("Failed to add phase " + name + ": the preceding phase does not exist.");
+    phase_names_.push_back(name);
+    const auto phase = static_cast<di::phase>(built_in_phase_count + phase_names_.size() - 1);
+    phase_order_.insert(position + 1, phase);
+    return phase;
+  }
+  // The phases in execution order.
+  const std::vector<di::phase>& phases() const
+  {
+    return phase_order_;
+  }
+
+  // Pins the workers to cores 1, 2, ..., leaving core 0 to the thread calling run(). Takes effect on the next call to run().
+  void        set_pin_workers (const bool pin_workers)
+  {
+    pin_workers_ = pin_workers;
+  }
+  bool        pin_workers     () const
+  {
+    return pin_workers_;
+  }
+
+  // Fans work out over the workers from within the hooks of a system, e.g. engine_->jobs().parallel_for(0, count, 64, function). Jobs are
+  // joined by the call which started them (parallel_for, task_group::wait or ~task_group), so they end within the phase. Without workers,
+  // jobs run serially.
+  di::job_system&   jobs         ()
+  {
+    return jobs_;
+  }
+  // Time per frame spent waiting for jobs, summed over the waiting threads, over the frames of the last call to run().
+  timing_statistics job_wait_time() const
+  {
+    return from_ticks(job_wait_.statistics());
+  }
+
+  // A non-zero fixed time step advances the simulation systems in constant steps drawn from an accumulator, at most max_steps_per_frame
+  // times per frame (excess time is dropped to avoid the spiral of death). Render systems then run once, with interpolation() in [0, 1)
+  // denoting how far the rendered frame lies between the last two simulation steps.
+  void        set_fixed_time_step(const duration time_step, const std::size_t max_steps_per_frame = 8)
+  {
+    fixed_time_step_     = time_step;
+    max_steps_per_frame_ = (std::max<std::size_t>)(max_steps_per_frame, 1);
+  }
+  duration    fixed_time_step    () const
+  {
+    return fixed_time_step_;
+  }
+  std::size_t max_steps_per_frame() const
+  {
+    return max_steps_per_frame_;
+  }
+  float       interpolation      () const
+  {
+    return interpolation_;
+  }
+
+  // A pipeline depth of n > 1 runs the simulation systems n - 1 frames ahead of the render systems. Each frame simulates frame i and
+  // renders frame i - n + 1 within a single task graph, so that simulation work proceeds while render systems block in WaitGetPoses or
+  // buffer swaps. The stages are not ordered against each other and should exchange data through a frame_state indexed by the frame
+  // index of the tick. Frames still in flight when the engine stops are not rendered. Set before run().
+  void              set_pipeline_depth(const std::size_t depth)
+  {
+    pipeline_depth_ = (std::max<std::size_t>)(depth, 1);
+  }
+  std::size_t       pipeline_depth    () const
+  {
+    return pipeline_depth_;
+  }
+  // Rolling mean, deviation, jitter and percentiles of the frame times over the last window_size frames of run(). Zero (default) disables
+  // them; the cost is a few floating point operations per frame otherwise.
+  void              set_frame_statistics_window(const std::size_t window_size)
+  {
+    frame_timer_.set_window_size(window_size);
+  }
+  frame_statistics  frame_time_statistics      () const
+  {
+    return frame_timer_.statistics();
+  }
+  // Time from the start of a frame's simulation to the end of its rendering, over the frames rendered by the last call to run().
+  timing_statistics frame_latency     () const
+  {
+    return from_ticks(frame_latency_.statistics());
+  }
+
+#ifdef DI_FRAME_TASKS
+  // Starts the task on the calling thread. It is then resumed by run(), on the thread calling it, at the frame boundaries it awaits.
+  void spawn(frame_task task)
+  {
+    task.start(scheduler_);
+  }
+#endif
+
+  // In idle mode, run() blocks after a frame unless a system is continuous, a change is pending or a frame task is due. It wakes on
+  // events of the idle source (input_system provides one for SDL events), wake(), the next frame task timer or the idle timeout.
+  void                      set_idle_mode   (const bool idle_mode)
+  {
+    idle_mode_ = idle_mode;
+  }
+  bool                      idle_mode       () const
+  {
+    return idle_mode_;
+  }
+  void                      set_idle_timeout(const std::chrono::milliseconds timeout)
+  {
+    idle_timeout_ = timeout;
+  }
+  std::chrono::milliseconds idle_timeout    () const
+  {
+    return idle_timeout_;
+  }
+  void                      set_idle_source (idle_source source)
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    idle_source_ = std::move(source);
+  }
+  // Ends the current or next idle wait. Thread-safe.
+  void                      wake            ()
+  {
+    {
+      std::lock_guard<std::mutex> lock(idle_mutex_);
+      wake_requested_ = true;
+      if (idle_source_.interrupt)
+        idle_source_.interrupt();
+    }
+    idle_condition_.notify_all();
+  }
+
+  // Per-system startup timings of the last call to run(), in the order of the systems, and the wall time from run() to the first frame.
+  const std::vector<startup_timing>& startup_timings () const
+  {
+    return startup_timings_;
+  }
+  std::chrono::nanoseconds           startup_duration() const
+  {
+    return startup_duration_;
+  }
+
+  // Typed events between systems and threads: posted lock-free from any thread, delivered in batches at the end of the phase chosen by
+  // the subscribers, on the thread calling run() (after the whole frame if pipelined).
+  di::event_bus&       events()
+  {
+    return events_;
+  }
+  const di::event_bus& events() const
+  {
+    return events_;
+  }
+
+  // Delayed and periodic callbacks on engine time, e.g. engine_->timers().schedule(std::chrono::milliseconds(300), [this] { end_fade(); }),
+  // with constant time scheduling and cancelling from any thread. Advanced by the frame delta at the start of each frame, before the
+  // systems run, or in fixed step mode by the time step before each simulation step (per frame if pipelined). Callbacks run on the thread
+  // calling run() and wake an idle engine. Timers persist across calls to run().
+  di::timer_wheel&       timers()
+  {
+    return timers_;
+  }
+  const di::timer_wheel& timers() const
+  {
+    return timers_;
+  }
+
+  // Opt-in timing of each system's pre_tick, tick and post_tick, kept as rolling histograms. Takes effect on the next call to run().
+  // When disabled, the dispatch is identical to the unprofiled one.
+  void              set_profiling_enabled(const bool enabled)
+  {
+    profiling_enabled_ = enabled;
+  }
+  bool              profiling_enabled    () const
+  {
+    return profiling_enabled_;
+  }
+  timing_statistics system_timings       (const system* system, const phase phase) const
+  {
+    return system && system->timings_ && static_cast<std::size_t>(phase) < built_in_phase_count ? (*system->timings_)[static_cast<std::size_t>(phase)].statistics() : timing_statistics();
+  }
   template<typename system_type>
-  static bool system_match_predicate(const std::unique_ptr<system>& iteratee)
+  timing_statistics system_timings       (const phase phase)
+  {
+    return system_timings(get_system<system_type>(), phase);
+  }
+
+  // Keeps the last frames' system phase times, job wait, frame memory use and the channels of the systems (e.g. event counts) when enabled
+  // at run(), and dumps the frames around a frame slower than its threshold, from frame start to frame end excluding idle waits and frame
+  // limiting. Dumps are written by a worker if there are any, otherwise when run() returns. Dumps are read with flight_recorder::read or
+  // printed by the flight_dump tool.
+  di::flight_recorder&       flight_recorder()
+  {
+    return flight_recorder_;
+  }
+  const di::flight_recorder& flight_recorder() const
+  {
+    return flight_recorder_;
+  }
+
+  // Records frames and system phases (when enabled at run()) into a Chrome trace, written on demand or when run() returns.
+  di::trace_recorder&       trace_recorder()
+  {
+    return trace_recorder_;
+  }
+  const di::trace_recorder& trace_recorder() const
+  {
+    return trace_recorder_;
+  }
+
+  // Scratch memory for the current frame, e.g. std::pmr::vector<window*> or display_system::windows(std::pmr::polymorphic_allocator<window*>
+  // (&engine->frame_memory())). Reset at the start of each frame, so nothing allocated from it may outlive the frame; in a pipelined
+  // engine, use a frame_state to hand data from the simulation to the render stage instead. Thread-safe for allocation.
+  di::frame_arena&       frame_memory()
+  {
+    return frame_arena_;
+  }
+  const di::frame_arena& frame_memory() const
+  {
+    return frame_arena_;
+  }
+
+  // Paces run() to a target frame rate (disabled by default). Also exposes the frame pacing error statistics.
+  di::frame_limiter&       frame_limiter()
+  {
+    return frame_limiter_;
+  }
+  const di::frame_limiter& frame_limiter() const
+  {
+    return frame_limiter_;
+  }
+
+protected:
+  using accumulator = std::chrono::duration<double, std::milli>;
+
+  static constexpr std::size_t built_in_phase_count = 3;
+
+  struct schedule
+  {
+    di::phase                phase;
+    task_graph               graph;
+    std::vector<std::size_t> order;
+  };
+  using schedules = std::deque<schedule>; // One per phase, in execution order. A deque, as task graphs do not move.
+
+  struct change
+  {
+    std::unique_ptr<di::system> instance; // Null for a removal.
+    std::size_t                 type_id ;
+    std::string_view            name    ;
+    std::uint8_t                hooks   ;
+  };
+  struct deferred_system
   {
-    return typeid(system_type) == typeid(*iteratee.get());
+    std::size_t                               position   ;
+    std::size_t                               type_id    ;
+    std::string_view                          name       ;
+    std::uint8_t                              hooks      ;
+    bool                                      main_thread;
+    std::function<std::unique_ptr<system>()>  construct  ;
+  };
+
+  system* attach       (std::unique_ptr<system> system, const std::size_t id, const std::string_view name, const std::uint8_t hooks, const std::size_t position)
+  {
+    system->engine_           = this;
+    system->running_          = &is_running_;
+    system->trace_recorder_   = &trace_recorder_;
+    system->flight_recorder_  = &flight_recorder_;
+    system->type_id_          = id;
+    system->name_             = name;
+    system->overridden_hooks_ = hooks;
+    if (id >= slots_.size())
+      slots_.resize(id + 1, nullptr);
+    if (!slots_[id])
+      slots_[id] = system.get();
+    const auto pointer = system.get();
+    systems_.insert(systems_.begin() + (std::min)(position, systems_.size()), std::move(system));
+    return pointer;
+  }
+
+  void    detach       (const std::size_t id)
+  {
+    deferred_systems_.erase(std::remove_if(deferred_systems_.begin(), deferred_systems_.end(), [id] (const deferred_system& iteratee)
+    {
+      return iteratee.type_id == id;
+    }), deferred_systems_.end());
+    if (id >= slots_.size() || !slots_[id]) return;
+    slots_[id] = nullptr;
+    systems_.erase(std::remove_if(systems_.begin(), systems_.end(), [id] (const std::unique_ptr<system>& iteratee)
+    {
+      return iteratee->type_id_ == id;
+    }), systems_.end());
   }
-  
-  std::vector<std::unique_ptr<system>> systems_    ;
-  frame_timer<float, std::milli>       frame_timer_;
-  bool                                 is_running_ = false;
+  void    enqueue      (change&& change)
+  {
+    std::lock_guard<std::mutex> lock(changes_mutex_);
+    changes_.push_back(std::move(change));
+    changes_pending_.store(true, std::memory_order_release);
+  }
+  // Applies the queued changes in order. Hooks run outside the lock, so they may request further changes for the next frame.
+  void    apply_changes(const bool run_hooks)
+  {
+    std::vector<change> changes;
+    {
+      std::lock_guard<std::mutex> lock(changes_mutex_);
+      changes.swap(changes_);
+      changes_pending_.store(false, std::memory_order_relaxed);
+    }
+    if (changes.empty()) return;
+
+    for (auto& change : changes)
+    {
+      if (change.instance)
+      {
+        const auto system = attach(std::move(change.instance), change.type_id, change.name, change.hooks, systems_.size());
+        reset_tick_rate(*system, tick_rate_time(*system));
+        if (run_hooks && system->overrides(system_hook::initialize)) system->initialize();
+      }
+      else
+      {
+        if (run_hooks)
+          for (auto& system : systems_)
+            if (system->type_id_ == change.type_id && system->overrides(system_hook::terminate))
+              system->terminate();
+        detach(change.type_id);
+      }
+    }
+    if (run_hooks)
+      build_schedules();
+  }
+
+  static bool conflicts             (const system& lhs, const system& rhs)
+  {
+    if ((lhs.reads_.empty() && lhs.writes_.empty()) || (rhs.reads_.empty() && rhs.writes_.empty()))
+      return true;
+    for (auto& resource : lhs.writes_)
+      if (std::find(rhs.reads_ .begin(), rhs.reads_ .end(), resource) != rhs.reads_ .end() ||
+          std::find(rhs.writes_.begin(), rhs.writes_.end(), resource) != rhs.writes_.end())
+        return true;
+    for (auto& resource : rhs.writes_)
+      if (std::find(lhs.reads_ .begin(), lhs.reads_ .end(), resource) != lhs.reads_ .end())
+        return true;
+    return false;
+  }
+  static bool depends               (const system& dependent, const system& dependency)
+  {
+    return std::find(dependent.dependencies_.begin(), dependent.dependencies_.end(), dependency.type_id_) != dependent.dependencies_.end();
+  }
+  // Orders the systems after the systems they depend on, otherwise in the order they were added, then adds an edge along that order
+  // between each pair of systems which depend on or conflict with each other, so that the graph is acyclic. Throws if the dependencies
+  // form a cycle.
+  static void add_edges(task_graph& graph, const std::vector<system*>& systems, const std::vector<std::size_t>& nodes)
+  {
+    std::vector<std::size_t> order ;
+    std::vector<bool>        placed(systems.size(), false);
+    order.reserve(systems.size());
+    while (order.size() < systems.size())
+    {
+      auto next = systems.size();
+      for (std::size_t i = 0; i < systems.size() && next == systems.size(); ++i)
+      {
+        if (placed[i]) continue;
+        auto ready = true;
+        for (std::size_t j = 0; j < systems.size() && ready; ++j)
+          ready = placed[j] || j == i || !depends(*systems[i], *systems[j]);
+        if (ready)
+          next = i;
+      }
+      if (next == systems.size())
+      {
+        const auto blocked = std::find(placed.begin(), placed.end(), false) - placed.begin();
+        throw std::runtime_error("The dependencies of " + std::string(systems[blocked]->name_) + " form a cycle.");
+      }
+      placed[next] = true;
+      order.push_back(next);
+    }
+
+    for (std::size_t i = 0; i < order.size(); ++i)
+      for (std::size_t j = i + 1; j < order.size(); ++j)
+      {
+        const auto& lhs = *systems[order[i]];
+        const auto& rhs = *systems[order[j]];
+        if (depends(rhs, lhs) || conflicts(lhs, rhs))
+          graph.add_edge(nodes[order[i]], nodes[order[j]]);
+      }
+  }
+  // Adds a node running the hook of the phase for each system with one, i.e. which overrides the hook of a built-in phase or registered a
+  // hook for a custom phase, so that systems without work in a phase cost nothing in it. The nodes are ordered by the dependencies and
+  // resource conflicts among them. Non-empty predecessors are joined through a barrier node which precedes all of the added nodes. Returns
+  // the added nodes, or the predecessors if no system has a hook.
+  std::vector<std::size_t> add_phase_nodes(task_graph& graph, const std::vector<system*>& systems, const di::phase phase, const std::vector<std::size_t>& predecessors)
+  {
+    static const std::array<void (system::*)(), built_in_phase_count> hooks {{&system::pre_tick, &system::tick, &system::post_tick}};
+    static const std::array<std::string_view  , built_in_phase_count> names {{"pre_tick", "tick", "post_tick"}};
+
+    const auto index    = static_cast<std::size_t>(phase);
+    const auto built_in = index < built_in_phase_count;
+    const auto name     = built_in ? names[index] : std::string_view(phase_names_[index - built_in_phase_count]);
+
+    std::vector<system*>     participants;
+    std::vector<std::size_t> custom_hooks;
+    for (auto system : systems)
+    {
+      if (built_in)
+      {
+        if (system->overrides(phase_hook_of(phase)))
+          participants.push_back(system);
+        continue;
+      }
+      const auto iterator = std::find_if(system->phase_hooks_.begin(), system->phase_hooks_.end(), [name] (const system::phase_hook& hook) { return hook.phase == name; });
+      if (iterator != system->phase_hooks_.end())
+      {
+        participants.push_back(system);
+        custom_hooks.push_back(static_cast<std::size_t>(iterator - system->phase_hooks_.begin()));
+      }
+    }
+    if (participants.empty())
+      return predecessors;
+
+    std::vector<std::size_t> nodes;
+    for (std::size_t i = 0; i < participants.size(); ++i)
+    {
+      const auto system = participants[i];
+      if (built_in)
+        nodes.push_back(add_hook_node(graph, system, name, profiling_enabled_ ? &(*system->timings_)[index] : nullptr, [system, hook = hooks[index]] { (system->*hook)(); }));
+      else
+        nodes.push_back(add_hook_node(graph, system, name, nullptr, [system, hook = custom_hooks[i]] { system->phase_hooks_[hook].function(); }));
+    }
+    add_edges(graph, participants, nodes);
+    if (!predecessors.empty())
+    {
+      const auto barrier = graph.add_node([] { });
+      for (auto predecessor : predecessors)
+        graph.add_edge(predecessor, barrier);
+      for (auto node : nodes)
+        graph.add_edge(barrier, node);
+    }
+    return nodes;
+  }
+  template<typename hook_type>
+  std::size_t add_hook_node(task_graph& graph, system* system, const std::string_view name, timing_histogram* histogram, const hook_type& hook)
+  {
+    // Tracing is sampled when the schedules are built, so that neither profiling nor tracing cost anything unless enabled at run().
+    const auto recorder = trace_recorder_.enabled() ? &trace_recorder_ : nullptr;
+    const auto flight   = flight_recording_ ? &flight_recorder_ : nullptr;
+    if (!histogram && !recorder && !flight)
+      return graph.add_node([system, hook] { if (system->due_) hook(); }, system->main_thread_only_);
+
+    return graph.add_node([system, hook, name, recorder, histogram, flight, channel = flight ? flight->channel(std::string(system->name_) + "/" + std::string(name)) : std::size_t(0)]
+    {
+      if (!system->due_) return;
+      const auto start = tsc_clock::ticks();
+      hook();
+      const auto end   = tsc_clock::ticks();
+      if (histogram) histogram->record(tsc_clock::to_duration(end - start));
+      if (recorder ) recorder ->record(system->name_, name, start, end);
+      if (flight   ) flight   ->add   (channel, std::chrono::duration<double, std::milli>(tsc_clock::to_duration(end - start)).count());
+    }, system->main_thread_only_);
+  }
+  void build_schedules(schedules& schedules, const std::vector<system*>& systems)
+  {
+    schedules.clear();
+    for (auto phase : phase_order_)
+    {
+      auto& schedule = schedules.emplace_back();
+      schedule.phase = phase;
+      add_phase_nodes(schedule.graph, systems, phase, {});
+      schedule.order = schedule.graph.topological_order();
+    }
+  }
+  void build_schedules()
+  {
+    std::vector<system*> systems;
+    simulation_systems_      .clear();
+    render_systems_          .clear();
+    rated_simulation_systems_.clear();
+    rated_render_systems_    .clear();
+    for (auto& system : systems_)
+    {
+      if (profiling_enabled_ && !system->timings_)
+        system->timings_ = std::make_unique<std::array<timing_histogram, 3>>();
+      systems.push_back(system.get());
+      (system->stage_ == system_stage::simulation ? simulation_systems_ : render_systems_).push_back(system.get());
+      if (system->tick_frequency_ > 0.0 || system->tick_divisor_ > 1)
+        (system->stage_ == system_stage::simulation ? rated_simulation_systems_ : rated_render_systems_).push_back(system.get());
+      else
+        system->due_ = true;
+    }
+    build_schedules(schedules_           , systems            );
+    build_schedules(simulation_schedules_, simulation_systems_);
+    build_schedules(render_schedules_    , render_systems_    );
+    pipelined_schedules_.clear();
+  }
+  // The pipelined schedule for a number of simulation steps chains the phases of the steps and, independently, the phases of the render
+  // systems into one graph. Built on first use, as the step count varies in fixed step mode.
+  schedule& pipelined_schedule(const std::size_t steps)
+  {
+    if (pipelined_schedules_.size() <= steps)
+      pipelined_schedules_.resize(steps + 1);
+    auto& entry = pipelined_schedules_[steps];
+    if (!entry)
+    {
+      entry = std::make_unique<schedule>();
+      std::vector<std::size_t> nodes;
+      for (std::size_t step = 0; step < steps; ++step)
+        for (auto phase : phase_order_)
+          nodes = add_phase_nodes(entry->graph, simulation_systems_, phase, nodes);
+      nodes.clear();
+      for (auto phase : phase_order_)
+        nodes = add_phase_nodes(entry->graph, render_systems_    , phase, nodes);
+      entry->order = entry->graph.topological_order();
+    }
+    return *entry;
+  }
+  // Constructs the deferred systems and initializes all systems, each concurrently where the systems allow, then builds the schedules.
+  // Startup is timed with std::chrono::steady_clock rather than tsc_clock, whose calibration on first use would add its own sleep to the
+  // timings. Trace spans still take tsc_clock ticks, which need no calibration until they are written.
+  void start_up                  ()
+  {
+    const auto start = std::chrono::steady_clock::now();
+
+    // Deferred construction is worth a few temporary threads when the engine has none.
+    std::unique_ptr<thread_pool> startup_pool;
+    auto pool = thread_pool_.get();
+    if (!pool && !deferred_systems_.empty())
+    {
+      startup_pool = std::make_unique<thread_pool>((std::max)(std::thread::hardware_concurrency(), 2u));
+      pool         = startup_pool.get();
+    }
+
+    construct_deferred_systems(pool);
+    build_schedules();
+    initialize_systems(pool);
+
+    startup_duration_ = std::chrono::steady_clock::now() - start;
+  }
+  void construct_deferred_systems(thread_pool* pool)
+  {
+    if (deferred_systems_.empty()) return;
+
+    // Main-thread constructors are queued in order and run by the calling thread, the rest run on the pool.
+    auto                                 deferred_systems = std::move(deferred_systems_);
+    std::vector<std::unique_ptr<system>> constructed(deferred_systems.size());
+    task_graph                           graph;
+    deferred_systems_.clear();
+    for (std::size_t i = 0; i < deferred_systems.size(); ++i)
+      graph.add_node([this, &deferred = deferred_systems[i], &system = constructed[i]]
+      {
+        const auto start      = tsc_clock::ticks();
+        const auto start_time = std::chrono::steady_clock::now();
+        system = deferred.construct();
+        system->construction_time_ = std::chrono::steady_clock::now() - start_time;
+        trace_recorder_.record(deferred.name, "construct", start, tsc_clock::ticks());
+      }, deferred_systems[i].main_thread);
+    graph.execute(*pool);
+
+    for (std::size_t i = 0; i < deferred_systems.size(); ++i)
+      attach(std::move(constructed[i]), deferred_systems[i].type_id, deferred_systems[i].name, deferred_systems[i].hooks, deferred_systems[i].position);
+  }
+  // Runs initialize() of the systems which override it, ordered by the same dependencies and resource conflicts as the phases.
+  void initialize_systems        (thread_pool* pool)
+  {
+    std::vector<system*>     systems;
+    std::vector<std::size_t> nodes  ;
+    task_graph               graph  ;
+    startup_timings_.assign(systems_.size(), startup_timing());
+    for (std::size_t i = 0; i < systems_.size(); ++i)
+    {
+      const auto system = systems_[i].get();
+      startup_timings_[i].name         = system->name_;
+      startup_timings_[i].construction = system->construction_time_;
+      if (!system->overrides(system_hook::initialize))
+        continue;
+      systems.push_back(system);
+      nodes  .push_back(graph.add_node([this, system, &timing = startup_timings_[i]]
+      {
+        const auto start      = tsc_clock::ticks();
+        const auto start_time = std::chrono::steady_clock::now();
+        system->initialize();
+        timing.initialization = std::chrono::steady_clock::now() - start_time;
+        trace_recorder_.record(system->name_, "initialize", start, tsc_clock::ticks());
+      }, system->main_thread_only_ || std::is_same<default_signal_policy, unsynchronized_signal_policy>::value));
+    }
+    add_edges(graph, systems, nodes);
+    if (pool)
+      graph.execute(*pool);
+    else
+      graph.execute(graph.topological_order());
+  }
+  void idle           ()
+  {
+    if (!is_running_ || changes_pending_.load(std::memory_order_acquire) ||
+        std::any_of(systems_.begin(), systems_.end(), [] (const std::unique_ptr<system>& system) { return system->continuous_; }))
+      return;
+
+    const auto now      = frame_scheduler::clock::now();
+    const auto timeout  = (std::min<timer_wheel::duration>)(timers_.next_expiry(), idle_timeout_);
+    const auto deadline = (std::min)(scheduler_.next_resumption(), now + std::chrono::duration_cast<frame_scheduler::clock::duration>(timeout));
+    if (deadline <= now)
+      return;
+
+    trace_scope                  scope(&trace_recorder_, "idle", "engine");
+    std::unique_lock<std::mutex> lock (idle_mutex_);
+    if (!wake_requested_)
+    {
+      if (idle_source_.wait)
+      {
+        lock.unlock(); // The source is only replaced by systems, on this thread.
+        idle_source_.wait(std::chrono::ceil<std::chrono::milliseconds>(deadline - now));
+        lock.lock  ();
+      }
+      else
+        idle_condition_.wait_until(lock, deadline, [&] { return wake_requested_; });
+    }
+    wake_requested_ = false;
+  }
+  // Resumes the tasks waiting for each built-in phase if requested, which is done for the last schedules of the frame.
+  void run_schedules  (schedules& schedules, const bool resume_tasks = false)
+  {
+    for (auto& schedule : schedules)
+    {
+      if (thread_pool_)
+        schedule.graph.execute(*thread_pool_);
+      else
+        schedule.graph.execute(schedule.order);
+      events_.dispatch(schedule.phase);
+      if (resume_tasks)
+        scheduler_.end_phase(schedule.phase);
+    }
+  }
+  // Consumes the frame delta into the accumulator and returns the number of fixed steps to simulate. Updates the interpolation.
+  std::size_t advance_accumulator()
+  {
+    accumulator_ += frame_timer_.delta_time();
+
+    std::size_t steps = 0;
+    while (accumulator_ >= fixed_time_step_ && steps < max_steps_per_frame_)
+    {
+      accumulator_ -= fixed_time_step_;
+      ++steps;
+    }
+    if (accumulator_ >= fixed_time_step_)
+      accumulator_  = accumulator(std::fmod(accumulator_.count(), accumulator(fixed_time_step_).count()));
+
+    interpolation_ = static_cast<float>(accumulator_ / accumulator(fixed_time_step_));
+    return steps;
+  }
+  static void set_frame(const std::vector<system*>& systems, const duration delta_time, const std::size_t frame_index)
+  {
+    for (auto system : systems)
+    {
+      system->delta_time_  = delta_time;
+      system->frame_index_ = frame_index;
+    }
+  }
+  // The time the tick rate of the system is updated against: the time of the fixed steps taken for simulation systems in fixed step mode,
+  // which falls behind the elapsed time whenever max_steps_per_frame drops time, and the elapsed time otherwise.
+  accumulator tick_rate_time   (const system& system) const
+  {
+    if (system.stage_ == system_stage::simulation && fixed_time_step_ != duration::zero() && pipeline_depth_ == 1)
+      return accumulator(fixed_time_step_) * static_cast<double>(step_index_);
+    return elapsed_time_;
+  }
+  static void reset_tick_rate  (system& system, const accumulator time)
+  {
+    system.due_            = true;
+    system.tick_period_    = (std::numeric_limits<std::uint64_t>::max)();
+    system.last_tick_time_ = time;
+  }
+  // Decides whether each system with a tick rate ticks at this opportunity (a frame, or a fixed step) and sets its delta time to the
+  // time since its last tick. Periods are counted from the start of run(), so that rates stay phase-aligned instead of drifting apart.
+  static void update_tick_rates(const std::vector<system*>& systems, const std::size_t opportunity, const accumulator time)
+  {
+    for (auto system : systems)
+    {
+      if (system->tick_divisor_ > 1)
+        system->due_ = opportunity % system->tick_divisor_ == 0;
+      else
+      {
+        const auto period    = static_cast<std::uint64_t>(time.count() * system->tick_frequency_ / 1000.0);
+        system->due_         = period != system->tick_period_;
+        system->tick_period_ = period;
+      }
+      if (system->due_)
+      {
+        system->delta_time_     = time - system->last_tick_time_;
+        system->last_tick_time_ = time;
+      }
+    }
+  }
+  void run_fixed_step ()
+  {
+    const auto steps = advance_accumulator();
+    set_frame(simulation_systems_, fixed_time_step_, frame_index_);
+    for (std::size_t step = 0; step < steps; ++step, ++step_index_)
+    {
+      update_tick_rates(rated_simulation_systems_, step_index_, accumulator(fixed_time_step_) * static_cast<double>(step_index_));
+      timers_.advance(fixed_time_step_);
+      run_schedules(simulation_schedules_);
+    }
+    set_frame(render_systems_, frame_timer_.delta_time(), frame_index_);
+    update_tick_rates(rated_render_systems_, frame_index_, elapsed_time_);
+    run_schedules(render_schedules_, true);
+  }
+  void record_flight  (const std::uint64_t job_wait, const std::uint64_t frame_start)
+  {
+    const auto overflows = frame_arena_.overflow_count();
+    flight_recorder_.set(flight_channels_[0], std::chrono::duration<double, std::milli>(tsc_clock::to_duration(job_wait)).count());
+    flight_recorder_.set(flight_channels_[1], static_cast<double>(frame_arena_.size()));
+    flight_recorder_.set(flight_channels_[2], static_cast<double>(overflows - frame_overflows_));
+    frame_overflows_ = overflows;
+    if (flight_recorder_.end_frame(tsc_clock::to_duration(tsc_clock::ticks() - frame_start)) && thread_pool_)
+      thread_pool_->submit([this] { flight_recorder_.write_dumps(); });
+  }
+  // The frame latency and job wait histograms hold tsc_clock ticks, converted when queried so that frames do not calibrate the clock.
+  static timing_statistics from_ticks(timing_statistics statistics)
+  {
+    if (statistics.count == 0) return statistics;
+    for (auto value : {&statistics.p50, &statistics.p95, &statistics.p99, &statistics.max})
+      *value = tsc_clock::to_duration(static_cast<std::uint64_t>(value->count()));
+    return statistics;
+  }
+  // Simulates frame_index_ and renders the frame simulated pipeline_depth_ - 1 frames earlier. Until the pipeline fills, only simulates.
+  void run_pipelined  ()
+  {
+    const auto fixed = fixed_time_step_ != duration::zero();
+    const auto steps = fixed ? advance_accumulator() : std::size_t(1);
+    set_frame(simulation_systems_, fixed ? fixed_time_step_ : frame_timer_.delta_time(), frame_index_);
+    update_tick_rates(rated_simulation_systems_, frame_index_, elapsed_time_); // Per frame: the steps of a frame share one graph.
+    interpolations_[frame_index_ % pipeline_depth_] = interpolation_;
+    if (frame_index_ + 1 < pipeline_depth_)
+    {
+      for (std::size_t step = 0; step < steps; ++step)
+        run_schedules(simulation_schedules_);
+    }
+    else
+    {
+      const auto rendered_index = frame_index_ + 1 - pipeline_depth_;
+      interpolation_ = interpolations_[rendered_index % pipeline_depth_];
+      set_frame(render_systems_, frame_timer_.delta_time(), rendered_index);
+      update_tick_rates(rated_render_systems_, rendered_index, elapsed_time_);
+      auto& schedule = pipelined_schedule(steps);
+      if (thread_pool_)
+        schedule.graph.execute(*thread_pool_);
+      else
+        schedule.graph.execute(schedule.order);
+    }
+
+    // The phases of the stages interleave within the frame, so events are delivered and the tasks waiting for them resume after it.
+    for (auto phase : phase_order_)
+      events_.dispatch(phase);
+    for (auto phase : phase_order_)
+      scheduler_.end_phase(phase);
+  }
+
+  di::frame_arena                      frame_arena_ ; // Destroyed last, after anything which may still hold frame memory.
+  std::vector<std::unique_ptr<system>> systems_     ;
+  frame_scheduler                      scheduler_   ; // Destroyed before the systems, which unfinished tasks may refer to.
+  di::timer_wheel                      timers_      ; // Likewise for the callbacks.
+  di::event_bus                        events_      ; // Likewise for the handlers.
+  bool                                 idle_mode_      = false;
+  std::chrono::milliseconds            idle_timeout_   {500};
+  idle_source                          idle_source_    ;
+  bool                                 wake_requested_ = false;
+  std::mutex                           idle_mutex_     ;
+  std::condition_variable              idle_condition_ ;
+  std::vector<deferred_system>         deferred_systems_;
+  std::vector<startup_timing>          startup_timings_ ;
+  std::chrono::nanoseconds             startup_duration_ {0};
+  std::atomic<bool>                    defers_changes_   {false};
+  std::atomic<bool>                    changes_pending_  {false};
+  std::vector<change>                  changes_          ;
+  std::mutex                           changes_mutex_    ;
+  std::vector<system*>                 slots_       ; // Indexed by type id, the first added system of each type.
+  frame_timer<float, std::milli>       frame_timer_ ;
+  std::atomic<bool>                    is_running_  {false};
+  std::size_t                          worker_count_ = 0;
+  std::unique_ptr<thread_pool>         thread_pool_ ;
+  bool                                 pin_workers_ = false;
+  di::job_system                       jobs_        ;
+  timing_histogram                     job_wait_    ;
+  std::vector<di::phase>               phase_order_         {di::phase::pre_tick, di::phase::tick, di::phase::post_tick};
+  std::deque<std::string>              phase_names_         ; // Of the custom phases, indexed by phase - built_in_phase_count.
+  schedules                            schedules_           ;
+  schedules                            simulation_schedules_;
+  schedules                            render_schedules_    ;
+  std::vector<std::unique_ptr<schedule>> pipelined_schedules_;
+  std::vector<system*>                 simulation_systems_  ;
+  std::vector<system*>                 render_systems_      ;
+  std::vector<system*>                 rated_simulation_systems_;
+  std::vector<system*>                 rated_render_systems_    ;
+  std::size_t                          step_index_          = 0;
+  accumulator                          elapsed_time_        ;
+  duration                             fixed_time_step_     = duration::zero();
+  std::size_t                          max_steps_per_frame_ = 8;
+  accumulator                          accumulator_         ;
+  float                                interpolation_       = 0.0F;
+  std::size_t                          pipeline_depth_      = 1;
+  std::size_t                          frame_index_         = 0;
+  std::vector<std::uint64_t>           frame_starts_        ; // tsc_clock ticks, indexed by frame index modulo the pipeline depth.
+  std::vector<float>                   interpolations_      ;
+  timing_histogram                     frame_latency_       ;
+  di::frame_limiter                    frame_limiter_       ;
+  bool                                 profiling_enabled_   = false;
+  di::trace_recorder                   trace_recorder_      ;
+  di::flight_recorder                  flight_recorder_     ;
+  bool                                 flight_recording_    = false;
+  std::array<std::size_t, 3>           flight_channels_     {}; // Job wait, frame memory and frame memory overflows.
+  std::size_t                          frame_overflows_     = 0;
 };
 }
 
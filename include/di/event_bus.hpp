@@ -0,0 +1,150 @@
+#ifndef DI_EVENT_BUS_HPP_
+#define DI_EVENT_BUS_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <di/utility/event_queue.hpp>
+#include <di/utility/span.hpp>
+#include <di/utility/type_id.hpp>
+#include <di/phase.hpp>
+
+namespace di
+{
+// Event bus lets systems exchange typed events across threads without locks or reentrancy. Producers post from any thread into a queue per
+// event type; consumers either subscribe for a phase, at the end of which the engine delivers the batch of the type to them, or drain the
+// batch themselves. Batches are contiguous, in order of posting per producer:
+//
+//   engine_->events().subscribe<pose_update>(di::phase::pre_tick, [this] (di::span<const pose_update> updates) { apply(updates); });
+//   engine_->events().post(pose_update {device, pose}); // E.g. from a tracking thread.
+class event_bus final
+{
+public:
+  explicit event_bus  (const std::size_t queue_capacity = 1024) : queue_capacity_(queue_capacity)
+  {
+
+  }
+  event_bus           (const event_bus&  that) = delete ;
+  event_bus           (      event_bus&& temp) = delete ;
+ ~event_bus           ()                       = default;
+  event_bus& operator=(const event_bus&  that) = delete ;
+  event_bus& operator=(      event_bus&& temp) = delete ;
+
+  // Thread-safe and lock-free, unless the type is posted for the first time or its queue is full.
+  template<typename event_type>
+  void                   post     (event_type event)
+  {
+    channel<event_type>().queue.post(std::move(event));
+  }
+  // Delivers the events of the type to the handler at the end of each run of the phase, on the thread calling run(), in batches which are
+  // valid for the duration of the call. All subscribers of a type receive the same batches, so they must subscribe for the same phase.
+  // Not thread-safe, e.g. call from the constructor or initialize() of a system.
+  template<typename event_type>
+  void                   subscribe(const phase phase, std::function<void(span<const event_type>)> handler)
+  {
+    auto& channel = this->channel<event_type>();
+    if (channel.subscribed && channel.phase != phase)
+      throw std::runtime_error("Subscribers of an event type must share the phase.");
+    if (!channel.subscribed)
+    {
+      const auto index = static_cast<std::size_t>(phase);
+      if (index >= phase_channels_.size())
+        phase_channels_.resize(index + 1);
+      phase_channels_[index].push_back(&channel);
+      channel.phase      = phase;
+      channel.subscribed = true;
+    }
+    channel.handlers.push_back(std::move(handler));
+  }
+  // Returns the events of the type posted since the last drain, valid until the next. For types without subscribers. Single consumer.
+  template<typename event_type>
+  span<const event_type> drain    ()
+  {
+    auto& channel = this->channel<event_type>();
+    channel.batch.clear();
+    channel.queue.drain(channel.batch);
+    return channel.batch;
+  }
+
+  // Delivers the batches of the types subscribed for the phase. Called by the engine after each phase.
+  void dispatch(const phase phase)
+  {
+    const auto index = static_cast<std::size_t>(phase);
+    if (index < phase_channels_.size())
+      for (auto channel : phase_channels_[index])
+        channel->dispatch();
+  }
+
+private:
+  struct channel_base
+  {
+    virtual ~channel_base() = default;
+    virtual void dispatch() = 0;
+
+    di::phase phase      = di::phase::pre_tick;
+    bool      subscribed = false;
+  };
+  template<typename event_type>
+  struct typed_channel : channel_base
+  {
+    explicit typed_channel(const std::size_t capacity) : queue(capacity)
+    {
+
+    }
+
+    void dispatch() override
+    {
+      batch.clear();
+      queue.drain(batch);
+      if (batch.empty()) return;
+      for (auto& handler : handlers)
+        handler(span<const event_type>(batch));
+    }
+
+    event_queue<event_type>                                  queue   ;
+    std::vector<event_type>                                  batch   ; // Reused, so that a steady state does not allocate.
+    std::vector<std::function<void(span<const event_type>)>> handlers;
+  };
+  using channel_table = std::vector<channel_base*>;
+
+  // Channels are looked up in an immutable table indexed by type id. Adding a channel publishes a copy, keeping the old tables alive for
+  // readers which may still hold them.
+  template<typename event_type>
+  typed_channel<event_type>& channel()
+  {
+    const auto id    = type_id<event_type>();
+    const auto table = table_.load(std::memory_order_acquire);
+    if (table && id < table->size() && (*table)[id])
+      return static_cast<typed_channel<event_type>&>(*(*table)[id]);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto current = table_.load(std::memory_order_relaxed);
+    if (current && id < current->size() && (*current)[id])
+      return static_cast<typed_channel<event_type>&>(*(*current)[id]);
+
+    channels_.push_back(std::make_unique<typed_channel<event_type>>(queue_capacity_));
+    auto copy = current ? std::make_unique<channel_table>(*current) : std::make_unique<channel_table>();
+    if (id >= copy->size())
+      copy->resize(id + 1, nullptr);
+    (*copy)[id] = channels_.back().get();
+    table_.store(copy.get(), std::memory_order_release);
+    tables_.push_back(std::move(copy));
+    return static_cast<typed_channel<event_type>&>(*channels_.back());
+  }
+
+  std::size_t                                 queue_capacity_;
+  std::atomic<const channel_table*>           table_         {nullptr};
+  std::mutex                                  mutex_         ;
+  std::vector<std::unique_ptr<channel_base>>  channels_      ;
+  std::vector<std::unique_ptr<channel_table>> tables_        ;
+  std::vector<std::vector<channel_base*>>     phase_channels_; // Indexed by phase.
+};
+}
+
+#endif
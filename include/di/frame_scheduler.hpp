@@ -0,0 +1,223 @@
+#ifndef DI_FRAME_SCHEDULER_HPP_
+#define DI_FRAME_SCHEDULER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <di/phase.hpp>
+
+namespace di
+{
+// A suspended task waiting to be resumed by a frame scheduler. Waiters are intrusive list nodes owned by the waiting task (e.g. the
+// awaiter in a coroutine frame), so that waiting and resuming never allocate.
+struct frame_waiter
+{
+  using clock = std::chrono::steady_clock;
+
+  void            (*resume)(void*) = nullptr;
+  void*             task           = nullptr;
+  frame_waiter*     next           = nullptr;
+  clock::time_point wake_time      ;
+};
+
+// Frame scheduler resumes waiting tasks at the frame boundaries of the engine: at the start of a frame and at the end of each phase.
+// Waits, resumption and destruction happen on the thread which runs the engine. Only signal() may be called from any thread.
+class frame_scheduler final
+{
+public:
+  using clock = frame_waiter::clock;
+
+  // A live task, linked into the scheduler so that unfinished tasks can be destroyed with it.
+  struct task_node
+  {
+    void       (*destroy)(void*) = nullptr;
+    void*        task            = nullptr;
+    task_node*   previous        = nullptr;
+    task_node*   next            = nullptr;
+  };
+
+  frame_scheduler           ()                             = default;
+  frame_scheduler           (const frame_scheduler&  that) = delete ;
+  frame_scheduler           (      frame_scheduler&& temp) = delete ;
+ ~frame_scheduler           ()
+  {
+    frame_waiters_ = waiter_list();
+    timers_        = waiter_list();
+    phase_waiters_.clear();
+    signaled_.store(nullptr, std::memory_order_relaxed);
+    while (tasks_) // Destroying a task unregisters it.
+      tasks_->destroy(tasks_->task);
+  }
+  frame_scheduler& operator=(const frame_scheduler&  that) = delete ;
+  frame_scheduler& operator=(      frame_scheduler&& temp) = delete ;
+
+  void        register_task  (task_node& node)
+  {
+    node.previous = nullptr;
+    node.next     = tasks_;
+    if (tasks_) tasks_->previous = &node;
+    tasks_ = &node;
+    ++task_count_;
+  }
+  void        unregister_task(task_node& node)
+  {
+    if (node.previous) node.previous->next = node.next; else tasks_ = node.next;
+    if (node.next    ) node.next->previous = node.previous;
+    --task_count_;
+  }
+  std::size_t task_count     () const
+  {
+    return task_count_;
+  }
+
+  void wait_frame (frame_waiter& waiter)
+  {
+    frame_waiters_.push_back(waiter);
+  }
+  // Custom phases grow the waiter lists on their first wait.
+  void wait_phase (frame_waiter& waiter, const phase phase)
+  {
+    const auto index = static_cast<std::size_t>(phase);
+    if (index >= phase_waiters_.size())
+      phase_waiters_.resize(index + 1);
+    phase_waiters_[index].push_back(waiter);
+  }
+  void wait_until (frame_waiter& waiter, const clock::time_point time)
+  {
+    waiter.wake_time = time;
+    earliest_timer_  = (std::min)(earliest_timer_, time);
+    timers_.push_back(waiter);
+  }
+  // Resumes the waiter at the next frame boundary. Thread-safe, lock-free apart from the signal handler.
+  void signal     (frame_waiter& waiter)
+  {
+    waiter.next = signaled_.load(std::memory_order_relaxed);
+    while (!signaled_.compare_exchange_weak(waiter.next, &waiter, std::memory_order_release, std::memory_order_relaxed))
+      ;
+    if (signal_handler_)
+      signal_handler_();
+  }
+  // Keeps the first exception thrown by a task, to be rethrown once all tasks due at the current frame boundary have resumed.
+  void fail       (std::exception_ptr exception)
+  {
+    if (!exception_) exception_ = std::move(exception);
+  }
+  void rethrow    ()
+  {
+    if (exception_) std::rethrow_exception(std::exchange(exception_, nullptr));
+  }
+  // Called after each signal, on the signaling thread. Lets an idle engine wake up. Set before tasks may be signaled.
+  void set_signal_handler(std::function<void()> handler)
+  {
+    signal_handler_ = std::move(handler);
+  }
+
+  // The earliest time a waiting task is due: clock::time_point::min() if a task awaits the next frame, a phase or has been signaled, the
+  // earliest wake time of the timers otherwise, or clock::time_point::max() if no task waits on anything.
+  clock::time_point next_resumption() const
+  {
+    if (frame_waiters_.head || signaled_.load(std::memory_order_relaxed) ||
+        std::any_of(phase_waiters_.begin(), phase_waiters_.end(), [] (const waiter_list& list) { return list.head != nullptr; }))
+      return (clock::time_point::min)();
+    return earliest_timer_;
+  }
+
+  // Resumes the signaled tasks, the tasks waiting for the next frame and those whose wake time has passed.
+  void begin_frame()
+  {
+    resume_signaled();
+    resume(frame_waiters_.take());
+
+    const auto  now = clock::now();
+    waiter_list expired;
+    waiter_list pending;
+    earliest_timer_ = (clock::time_point::max)();
+    for (auto waiter = timers_.take(); waiter; )
+    {
+      const auto next = waiter->next;
+      if (waiter->wake_time <= now)
+        expired.push_back(*waiter);
+      else
+      {
+        pending.push_back(*waiter);
+        earliest_timer_ = (std::min)(earliest_timer_, waiter->wake_time);
+      }
+      waiter = next;
+    }
+    timers_ = pending;
+    resume(expired.take());
+    rethrow();
+  }
+  // Resumes the signaled tasks and the tasks waiting for the end of the phase. A task waiting for the phase it was resumed in waits a frame.
+  void end_phase  (const phase phase)
+  {
+    resume_signaled();
+    if (static_cast<std::size_t>(phase) < phase_waiters_.size())
+      resume(phase_waiters_[static_cast<std::size_t>(phase)].take());
+    rethrow();
+  }
+
+private:
+  struct waiter_list
+  {
+    void          push_back(frame_waiter& waiter)
+    {
+      waiter.next = nullptr;
+      (tail ? tail->next : head) = &waiter;
+      tail = &waiter;
+    }
+    frame_waiter* take     ()
+    {
+      const auto waiters = head;
+      head = tail = nullptr;
+      return waiters;
+    }
+
+    frame_waiter* head = nullptr;
+    frame_waiter* tail = nullptr;
+  };
+
+  static void resume(frame_waiter* waiter)
+  {
+    while (waiter)
+    {
+      const auto next = waiter->next; // The waiter is gone once its task resumes.
+      waiter->resume(waiter->task);
+      waiter = next;
+    }
+  }
+  void resume_signaled()
+  {
+    if (!signaled_.load(std::memory_order_relaxed)) return;
+
+    // The stack holds the most recent signal first.
+    frame_waiter* waiters = nullptr;
+    for (auto waiter = signaled_.exchange(nullptr, std::memory_order_acquire); waiter; )
+    {
+      const auto next = waiter->next;
+      waiter->next = waiters;
+      waiters      = waiter;
+      waiter       = next;
+    }
+    resume(waiters);
+  }
+
+  waiter_list                frame_waiters_  ;
+  waiter_list                timers_         ;
+  clock::time_point          earliest_timer_ = (clock::time_point::max)();
+  std::vector<waiter_list>   phase_waiters_  = std::vector<waiter_list>(3); // Indexed by phase.
+  std::atomic<frame_waiter*> signaled_       {nullptr};
+  std::function<void()>      signal_handler_ ;
+  task_node*                 tasks_          = nullptr;
+  std::size_t                task_count_     = 0;
+  std::exception_ptr         exception_      ;
+};
+}
+
+#endif
@@ -0,0 +1,269 @@
+#ifndef DI_FRAME_TASK_HPP_
+#define DI_FRAME_TASK_HPP_
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define DI_FRAME_TASKS
+#endif
+
+#ifdef DI_FRAME_TASKS
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <utility>
+
+#include <di/frame_scheduler.hpp>
+#include <di/phase.hpp>
+
+namespace di
+{
+// Frame task is a coroutine which suspends across frames, replacing hand-written state machines in systems:
+//
+//   di::frame_task fade(di::hmd* hmd)
+//   {
+//     hmd->fade_to_color({0.0F, 0.0F, 0.0F, 1.0F});
+//     co_await di::wait_for(std::chrono::seconds(1));
+//     hmd->fade_to_color({0.0F, 0.0F, 0.0F, 0.0F});
+//   }
+//   engine_->spawn(fade(hmd));
+//
+// A spawned task runs until its first suspension, is resumed by the engine on the thread calling engine::run(), and is destroyed when it
+// completes or with the engine. Available when compiling as C++20 (DI_FRAME_TASKS is then defined).
+class frame_task final
+{
+public:
+  struct promise_type
+  {
+    promise_type           () = default;
+    promise_type           (const promise_type&  that) = delete;
+    promise_type           (      promise_type&& temp) = delete;
+   ~promise_type           ()
+    {
+      if (scheduler) scheduler->unregister_task(node);
+    }
+    promise_type& operator=(const promise_type&  that) = delete;
+    promise_type& operator=(      promise_type&& temp) = delete;
+
+    frame_task          get_return_object  ()
+    {
+      return frame_task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend    () noexcept
+    {
+      return {};
+    }
+    std::suspend_never  final_suspend      () noexcept
+    {
+      return {};
+    }
+    void                return_void        ()
+    {
+
+    }
+    // Ends the task. The exception propagates out of engine::run() (or spawn()) once the other tasks due at the same frame boundary have
+    // resumed.
+    void                unhandled_exception()
+    {
+      scheduler->fail(std::current_exception());
+    }
+
+    frame_scheduler*           scheduler = nullptr;
+    frame_scheduler::task_node node      ;
+  };
+
+  frame_task           (const frame_task&  that) = delete;
+  frame_task           (      frame_task&& temp) noexcept : handle_(std::exchange(temp.handle_, nullptr))
+  {
+
+  }
+ ~frame_task           ()
+  {
+    if (handle_) handle_.destroy();
+  }
+  frame_task& operator=(const frame_task&  that) = delete;
+  frame_task& operator=(      frame_task&& temp) noexcept
+  {
+    if (this != &temp)
+    {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(temp.handle_, nullptr);
+    }
+    return *this;
+  }
+
+  // Hands the task over to the scheduler and runs it until its first suspension.
+  void start(frame_scheduler& scheduler)
+  {
+    if (!handle_) return;
+    auto  handle  = std::exchange(handle_, nullptr);
+    auto& promise = handle.promise();
+    promise.scheduler    = &scheduler;
+    promise.node.task    = handle.address();
+    promise.node.destroy = [] (void* task) { std::coroutine_handle<>::from_address(task).destroy(); };
+    scheduler.register_task(promise.node);
+    handle.resume();
+    scheduler.rethrow();
+  }
+
+private:
+  explicit frame_task(const std::coroutine_handle<promise_type> handle) : handle_(handle)
+  {
+
+  }
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+class frame_awaiter
+{
+public:
+  bool await_ready () const noexcept
+  {
+    return false;
+  }
+  void await_resume() const noexcept
+  {
+
+  }
+
+protected:
+  frame_scheduler& prepare(const std::coroutine_handle<frame_task::promise_type> handle)
+  {
+    waiter_.task   = handle.address();
+    waiter_.resume = [] (void* task) { std::coroutine_handle<>::from_address(task).resume(); };
+    return *handle.promise().scheduler;
+  }
+
+  frame_waiter waiter_;
+};
+
+class next_frame_awaiter : public frame_awaiter
+{
+public:
+  void await_suspend(const std::coroutine_handle<frame_task::promise_type> handle)
+  {
+    prepare(handle).wait_frame(waiter_);
+  }
+};
+
+class phase_awaiter : public frame_awaiter
+{
+public:
+  explicit phase_awaiter(const phase phase) : phase_(phase)
+  {
+
+  }
+
+  void await_suspend(const std::coroutine_handle<frame_task::promise_type> handle)
+  {
+    prepare(handle).wait_phase(waiter_, phase_);
+  }
+
+private:
+  phase phase_;
+};
+
+class time_awaiter : public frame_awaiter
+{
+public:
+  explicit time_awaiter(const frame_scheduler::clock::time_point time) : time_(time)
+  {
+
+  }
+
+  void await_suspend(const std::coroutine_handle<frame_task::promise_type> handle)
+  {
+    prepare(handle).wait_until(waiter_, time_);
+  }
+
+private:
+  frame_scheduler::clock::time_point time_;
+};
+
+// Connects to the signal on suspension and disconnects on resumption. Works with any signal whose connect() accepts a callable and
+// returns a connection with disconnect(). The signal may be emitted from any thread; the task resumes at the next frame boundary. An
+// emission on another thread may still call the slot after it has been disconnected, so the slot shares the waiter and its flag with the
+// awaiter instead of pointing to it, and the awaiter raises the flag on destruction so that such a late call does nothing.
+template<typename signal_type>
+class signal_awaiter : public frame_awaiter
+{
+public:
+  explicit signal_awaiter  (signal_type& signal) : signal_(signal)
+  {
+
+  }
+  signal_awaiter           (const signal_awaiter&  that) = delete;
+  signal_awaiter           (      signal_awaiter&& temp) = delete;
+ ~signal_awaiter           ()
+  {
+    if (state_) state_->signaled.store(true, std::memory_order_release);
+    connection_.disconnect();
+  }
+  signal_awaiter& operator=(const signal_awaiter&  that) = delete;
+  signal_awaiter& operator=(      signal_awaiter&& temp) = delete;
+
+  void await_suspend(const std::coroutine_handle<frame_task::promise_type> handle)
+  {
+    state_            = std::make_shared<state>();
+    state_->scheduler = &prepare(handle);
+    state_->waiter    = waiter_;
+    connection_       = signal_.connect(slot {state_});
+  }
+  void await_resume ()
+  {
+    connection_.disconnect();
+  }
+
+private:
+  struct state
+  {
+    frame_scheduler*  scheduler = nullptr;
+    frame_waiter      waiter    ;
+    std::atomic<bool> signaled  {false};
+  };
+  struct slot
+  {
+    template<typename... argument_types>
+    void operator()(argument_types&&...) const
+    {
+      if (!shared->signaled.exchange(true, std::memory_order_acq_rel))
+        shared->scheduler->signal(shared->waiter);
+    }
+
+    std::shared_ptr<state> shared;
+  };
+  using connection_type = decltype(std::declval<signal_type&>().connect(std::declval<slot>()));
+
+  signal_type&           signal_    ;
+  std::shared_ptr<state> state_     ;
+  connection_type        connection_;
+};
+
+// Resumes at the start of the next frame.
+inline next_frame_awaiter         next_frame ()
+{
+  return next_frame_awaiter();
+}
+// Resumes at the end of the given phase: this frame's if it is still ahead, otherwise the next frame's.
+inline phase_awaiter              after_phase(const phase phase)
+{
+  return phase_awaiter(phase);
+}
+// Resumes at the start of the first frame after the duration has elapsed.
+template<typename representation, typename period>
+time_awaiter                      wait_for   (const std::chrono::duration<representation, period> duration)
+{
+  return time_awaiter(frame_scheduler::clock::now() + std::chrono::duration_cast<frame_scheduler::clock::duration>(duration));
+}
+// Resumes at the first frame boundary after the signal is emitted, e.g. co_await di::wait_signal(window->on_resize).
+template<typename signal_type>
+signal_awaiter<signal_type>       wait_signal(signal_type& signal)
+{
+  return signal_awaiter<signal_type>(signal);
+}
+}
+
+#endif
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef DI_PHASE_HPP_
+#define DI_PHASE_HPP_
+
+namespace di
+{
+// The per-frame phases of the engine, in execution order. Custom phases added by engine::add_phase take the values after post_tick.
+enum class phase
+{
+  pre_tick ,
+  tick     ,
+  post_tick
+};
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef DI_STATIC_ENGINE_HPP_
+#define DI_STATIC_ENGINE_HPP_
+
+#include <atomic>
+#include <tuple>
+#include <type_traits>
+
+#include <di/utility/frame_timer.hpp>
+#include <di/system.hpp>
+#include <di/system_traits.hpp>
+
+namespace di
+{
+// Static engine is the compile-time counterpart of engine for a fixed set of system types. The systems are default constructed in place
+// and the phases are dispatched with fold expressions on their concrete types, skipping the hooks a system does not override.
+// Systems are run serially in the given order. Their engine_ member is null; they stop the engine through system::stop_engine().
+template<typename... system_types>
+class static_engine
+{
+public:
+  static_assert(std::conjunction<std::is_base_of<system, system_types>...>::value, "The types do not inherit from system.");
+  static_assert(std::conjunction<std::is_default_constructible<system_types>...>::value, "The types are not default constructible.");
+
+  using duration = typename frame_timer<float, std::milli>::duration;
+
+  static_engine           ()
+  {
+    std::apply([&] (auto&... systems) { ((static_cast<system&>(systems).running_ = &is_running_), ...); }, systems_);
+  }
+  static_engine           (const static_engine&  that) = delete ;
+  static_engine           (      static_engine&& temp) = delete ;
+ ~static_engine           ()                           = default;
+  static_engine& operator=(const static_engine&  that) = delete ;
+  static_engine& operator=(      static_engine&& temp) = delete ;
+
+  template<typename system_type>
+  system_type* get_system()
+  {
+    return &std::get<system_type>(systems_);
+  }
+
+  void run       ()
+  {
+    if (is_running_) return;
+    is_running_ = true;
+
+    dispatch<overrides_initialize, initialize_hook>();
+
+    frame_timer_.tick();
+    while (is_running_)
+    {
+      frame_timer_.tick();
+      std::apply([&] (auto&... systems) { ((static_cast<system&>(systems).delta_time_ = frame_timer_.delta_time()), ...); }, systems_);
+      dispatch<overrides_pre_tick , pre_tick_hook >();
+      dispatch<overrides_tick     , tick_hook     >();
+      dispatch<overrides_post_tick, post_tick_hook>();
+    }
+
+    dispatch<overrides_terminate, terminate_hook>();
+  }
+  void stop      ()
+  {
+    is_running_ = false;
+  }
+  bool is_running() const
+  {
+    return is_running_;
+  }
+
+protected:
+  // Calls a hook qualified by the concrete type, which is not a virtual call and may be inlined. A hook the concrete type redeclares as
+  // non-public can not be named through it, so it falls back to the virtual call through system.
+  struct initialize_hook
+  {
+    template<typename system_type>
+    static auto call(system_type& system, int ) -> decltype(system.system_type::initialize()) { system.system_type::initialize(); }
+    template<typename system_type>
+    static void call(system_type& system, long) { static_cast<di::system&>(system).initialize(); }
+  };
+  struct pre_tick_hook
+  {
+    template<typename system_type>
+    static auto call(system_type& system, int ) -> decltype(system.system_type::pre_tick  ()) { system.system_type::pre_tick  (); }
+    template<typename system_type>
+    static void call(system_type& system, long) { static_cast<di::system&>(system).pre_tick  (); }
+  };
+  struct tick_hook
+  {
+    template<typename system_type>
+    static auto call(system_type& system, int ) -> decltype(system.system_type::tick      ()) { system.system_type::tick      (); }
+    template<typename system_type>
+    static void call(system_type& system, long) { static_cast<di::system&>(system).tick      (); }
+  };
+  struct post_tick_hook
+  {
+    template<typename system_type>
+    static auto call(system_type& system, int ) -> decltype(system.system_type::post_tick ()) { system.system_type::post_tick (); }
+    template<typename system_type>
+    static void call(system_type& system, long) { static_cast<di::system&>(system).post_tick (); }
+  };
+  struct terminate_hook
+  {
+    template<typename system_type>
+    static auto call(system_type& system, int ) -> decltype(system.system_type::terminate ()) { system.system_type::terminate (); }
+    template<typename system_type>
+    static void call(system_type& system, long) { static_cast<di::system&>(system).terminate (); }
+  };
+
+  template<template<typename, typename = void> class overrides, typename hook>
+  void dispatch()
+  {
+    std::apply([ ] (auto&... systems) { (invoke<overrides, hook>(systems), ...); }, systems_);
+  }
+  template<template<typename, typename = void> class overrides, typename hook, typename system_type>
+  static void invoke  (system_type& system)
+  {
+    if constexpr (overrides<system_type>::value)
+      hook::call(system, 0);
+  }
+
+  std::tuple<system_types...>    systems_    ;
+  frame_timer<float, std::milli> frame_timer_;
+  std::atomic<bool>              is_running_ {false};
+};
+}
+
+#endif
@@ -1,9 +1,32 @@
 #ifndef DI_SYSTEM_HPP_
 #define DI_SYSTEM_HPP_
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <di/utility/flight_recorder.hpp>
+#include <di/utility/timing_histogram.hpp>
+#include <di/utility/trace_recorder.hpp>
+#include <di/utility/type_id.hpp>
+#include <di/system_hook.hpp>
+#include <di/system_stage.hpp>
+
 namespace di
 {
 class engine;
+template<typename...>
+class static_engine;
 
 class system
 {
@@ -18,8 +41,115 @@ public:
 
 protected:
   friend class engine;
+  template<typename...>
+  friend class static_engine;
+
+  // Scheduling declarations, consumed by the engine when it builds the per-phase dependency graphs.
+  // Systems which access a common resource, at least one of them writing, run in the order they were added, after any dependencies.
+  // Systems which declare no resources are assumed to touch everything and are never run concurrently with another system.
+  void read_resource       (const std::string& resource)
+  {
+    reads_ .push_back(resource);
+  }
+  void write_resource      (const std::string& resource)
+  {
+    writes_.push_back(resource);
+  }
+  // Runs after the system of the type in the phases both take part in, even if it was added later. A cycle of dependencies makes run() throw.
+  template<typename system_type>
+  void depend_on           ()
+  {
+    dependencies_.push_back(type_id<system_type, system>());
+  }
+  void set_main_thread_only(const bool main_thread_only)
+  {
+    main_thread_only_ = main_thread_only;
+  }
+  void set_stage           (const system_stage stage)
+  {
+    stage_ = stage;
+  }
+  // Ticks (all of pre_tick, tick and post_tick) whenever the engine time crosses a multiple of 1 / frequency, instead of every frame.
+  // At most once per frame, or per fixed step for simulation systems in fixed step mode. Zero restores ticking every frame.
+  void set_tick_rate       (const double frequency)
+  {
+    tick_frequency_ = (std::max)(frequency, 0.0);
+    tick_divisor_   = 1;
+  }
+  // Ticks every divisor-th frame, or fixed step for simulation systems in fixed step mode.
+  void set_tick_divisor    (const std::size_t divisor)
+  {
+    tick_divisor_   = (std::max<std::size_t>)(divisor, 1);
+    tick_frequency_ = 0.0;
+  }
+  // Keeps an engine in idle mode ticking every frame while set, e.g. during an animation or while a VR compositor expects frames.
+  void set_continuous      (const bool continuous)
+  {
+    continuous_ = continuous;
+  }
+  // Runs the function in the custom phase of the name (see engine::add_phase), subject to the tick rate like the other phase hooks. A
+  // system has one hook per phase; adding another replaces it.
+  void add_phase_hook      (const std::string& phase, std::function<void()> function)
+  {
+    const auto iterator = std::find_if(phase_hooks_.begin(), phase_hooks_.end(), [&phase] (const phase_hook& hook) { return hook.phase == phase; });
+    if (iterator != phase_hooks_.end())
+      iterator->function = std::move(function);
+    else
+      phase_hooks_.push_back(phase_hook {phase, std::move(function)});
+  }
+
+  // Stops the engine or static_engine which owns the system at the end of the current frame. Does nothing for a system not owned by one.
+  void stop_engine         ()
+  {
+    if (running_) *running_ = false;
+  }
+
+  struct phase_hook
+  {
+    std::string           phase   ;
+    std::function<void()> function;
+  };
+
+  // Whether the hook is overridden, from the overridden hooks mask set by the engine from the concrete type.
+  bool overrides(const system_hook hook) const
+  {
+    return (overridden_hooks_ & hook_bit(hook)) != 0;
+  }
+
+  engine*                      engine_           = nullptr;
+  std::atomic<bool>*           running_          = nullptr; // The is_running flag of the owning engine or static_engine.
+  trace_recorder*              trace_recorder_   = nullptr; // Null unless owned by an engine. Systems may record their own spans into it.
+  flight_recorder*             flight_recorder_  = nullptr; // Null unless owned by an engine. Systems may record their own channels into it.
+  std::size_t                  type_id_          = (std::numeric_limits<std::size_t>::max)();
+  std::string_view             name_             ;
+  std::vector<std::string>     reads_            ;
+  std::vector<std::string>     writes_           ;
+  std::vector<std::size_t>     dependencies_     ;
+  bool                         main_thread_only_ = false;
+  bool                         continuous_       = false;
+  system_stage                 stage_            = system_stage::simulation;
+  std::uint8_t                 overridden_hooks_ = all_hooks;
+  std::vector<phase_hook>      phase_hooks_      ;
+
+  // Time advanced by the current tick: since the last tick of the system if it has a tick rate, otherwise the fixed time step for
+  // simulation systems in fixed step mode and the frame delta for the rest.
+  std::chrono::duration<float, std::milli> delta_time_ {0.0F};
+
+  // Tick rate state. Rates are aligned to a common origin, so that systems of commensurate rates tick on the same frames.
+  double                                    tick_frequency_ = 0.0;
+  std::size_t                               tick_divisor_   = 1;
+  bool                                      due_            = true;
+  std::uint64_t                             tick_period_    = (std::numeric_limits<std::uint64_t>::max)();
+  std::chrono::duration<double, std::milli> last_tick_time_ {0.0};
+
+  // Index of the frame the current tick belongs to. In a pipelined engine, simulation systems run ahead of render systems.
+  std::size_t                              frame_index_ = 0;
+
+  // Time spent in the constructor, measured by the engine.
+  std::chrono::nanoseconds                 construction_time_ {0};
 
-  engine* engine_ = nullptr;
+  // Per-phase hook timings, allocated by the engine when profiling is enabled.
+  std::unique_ptr<std::array<timing_histogram, 3>> timings_;
 };
 }
 
@@ -0,0 +1,38 @@
+#ifndef DI_SYSTEM_HOOK_HPP_
+#define DI_SYSTEM_HOOK_HPP_
+
+#include <cstdint>
+
+#include <di/phase.hpp>
+
+namespace di
+{
+// The virtual hooks of system. Each is a bit of the overridden hooks mask (see overridden_hooks in system_traits.hpp).
+enum class system_hook : std::uint8_t
+{
+  initialize,
+  pre_tick  ,
+  tick      ,
+  post_tick ,
+  terminate
+};
+
+constexpr std::uint8_t hook_bit(const system_hook hook)
+{
+  return static_cast<std::uint8_t>(1U << static_cast<unsigned>(hook));
+}
+constexpr std::uint8_t all_hooks = static_cast<std::uint8_t>((1U << (static_cast<unsigned>(system_hook::terminate) + 1)) - 1);
+
+// The hook run in a built-in phase.
+constexpr system_hook  phase_hook_of(const di::phase phase)
+{
+  switch (phase)
+  {
+  case di::phase::pre_tick : return system_hook::pre_tick ;
+  case di::phase::tick     : return system_hook::tick     ;
+  default                  : return system_hook::post_tick;
+  }
+}
+}
+
+#endif
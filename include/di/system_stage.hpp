@@ -0,0 +1,14 @@
+#ifndef DI_SYSTEM_STAGE_HPP_
+#define DI_SYSTEM_STAGE_HPP_
+
+namespace di
+{
+// Simulation systems advance in fixed steps when the engine runs with a fixed time step. Render systems run once per frame.
+enum class system_stage
+{
+  simulation,
+  render
+};
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef DI_SYSTEM_TRAITS_HPP_
+#define DI_SYSTEM_TRAITS_HPP_
+
+#include <cstdint>
+#include <type_traits>
+
+#include <di/system.hpp>
+#include <di/system_hook.hpp>
+
+namespace di
+{
+// Detect at compile time which hooks of system a system type overrides. The hooks are public in system, so a hook which is not
+// accessible through the system type (e.g. redeclared as protected) or whose member pointer is not of system has been overridden.
+template<typename system_type, typename = void>
+struct overrides_initialize : std::true_type { };
+template<typename system_type>
+struct overrides_initialize<system_type, std::void_t<decltype(&system_type::initialize)>>
+  : std::integral_constant<bool, !std::is_same<decltype(&system_type::initialize), void (system::*)()>::value> { };
+
+template<typename system_type, typename = void>
+struct overrides_pre_tick   : std::true_type { };
+template<typename system_type>
+struct overrides_pre_tick  <system_type, std::void_t<decltype(&system_type::pre_tick  )>>
+  : std::integral_constant<bool, !std::is_same<decltype(&system_type::pre_tick  ), void (system::*)()>::value> { };
+
+template<typename system_type, typename = void>
+struct overrides_tick       : std::true_type { };
+template<typename system_type>
+struct overrides_tick      <system_type, std::void_t<decltype(&system_type::tick      )>>
+  : std::integral_constant<bool, !std::is_same<decltype(&system_type::tick      ), void (system::*)()>::value> { };
+
+template<typename system_type, typename = void>
+struct overrides_post_tick  : std::true_type { };
+template<typename system_type>
+struct overrides_post_tick <system_type, std::void_t<decltype(&system_type::post_tick )>>
+  : std::integral_constant<bool, !std::is_same<decltype(&system_type::post_tick ), void (system::*)()>::value> { };
+
+template<typename system_type, typename = void>
+struct overrides_terminate  : std::true_type { };
+template<typename system_type>
+struct overrides_terminate <system_type, std::void_t<decltype(&system_type::terminate )>>
+  : std::integral_constant<bool, !std::is_same<decltype(&system_type::terminate ), void (system::*)()>::value> { };
+
+// The hook_bit of each hook the system type overrides.
+template<typename system_type>
+constexpr std::uint8_t overridden_hooks()
+{
+  return static_cast<std::uint8_t>(
+    (overrides_initialize<system_type>::value ? hook_bit(system_hook::initialize) : 0U) |
+    (overrides_pre_tick  <system_type>::value ? hook_bit(system_hook::pre_tick  ) : 0U) |
+    (overrides_tick      <system_type>::value ? hook_bit(system_hook::tick      ) : 0U) |
+    (overrides_post_tick <system_type>::value ? hook_bit(system_hook::post_tick ) : 0U) |
+    (overrides_terminate <system_type>::value ? hook_bit(system_hook::terminate ) : 0U));
+}
+
+// Specialize for system types whose constructor must run on the main thread (e.g. SDL subsystem initialization), so that deferred
+// construction does not move it to a worker.
+template<typename system_type>
+struct constructs_on_main_thread : std::false_type { };
+}
+
+#endif
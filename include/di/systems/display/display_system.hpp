@@ -9,13 +9,17 @@
 #include <string>
 #include <vector>
 
-#include <boost/signals2.hpp>
+#include <SDL2/SDL_events.h>
 #include <SDL2/SDL_video.h>
 
 #include <di/systems/display/opengl_window.hpp>
 #include <di/systems/display/vulkan_window.hpp>
 #include <di/systems/display/window.hpp>
+#include <di/systems/input/sdl_event_pump.hpp>
+#include <di/utility/flight_recorder.hpp>
+#include <di/utility/signal.hpp>
 #include <di/system.hpp>
+#include <di/system_traits.hpp>
 
 namespace di
 {
@@ -26,6 +30,12 @@ public:
   {
     if (SDL_VideoInit(nullptr) != 0)
       throw std::runtime_error("Failed to initialize SDL Video subsystem. Error: " + std::string(SDL_GetError()));
+
+    // SDL windows and their graphics contexts are bound to the thread which initialized the video subsystem.
+    set_main_thread_only(true);
+    write_resource      ("display"   );
+    write_resource      ("sdl_events");
+    set_stage           (system_stage::render);
   }
   display_system           (const display_system&  that) = delete ;
   display_system           (      display_system&& temp) = delete ;
@@ -65,9 +75,10 @@ public:
       }), 
       windows_.end  ());
   }
-  std::vector<window*> windows             () const
+  template<typename allocator_type = std::allocator<window*>>
+  std::vector<window*, allocator_type> windows(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<window*> windows(windows_.size());
+    std::vector<window*, allocator_type> windows(windows_.size(), allocator);
     std::transform(
       windows_.begin(), 
       windows_.end  (), 
@@ -82,102 +93,111 @@ public:
   window* window_with_input_grab    () const
   {
     const auto native = SDL_GetGrabbedWindow();
-    auto windows = this->windows();
-    for (auto& window : windows)
+    for (auto& window : windows_)
       if (window->native() == native)
-        return window;
+        return window.get();
     return nullptr;
   }
   window* window_with_keyboard_focus() const
   {
     const auto native = SDL_GetMouseFocus();
-    auto windows = this->windows();
-    for (auto& window : windows)
+    for (auto& window : windows_)
       if (window->native() == native)
-        return window;
+        return window.get();
     return nullptr;
   }
   window* window_with_mouse_focus   () const
   {
     const auto native = SDL_GetKeyboardFocus();
-    auto windows = this->windows();
-    for (auto& window : windows)
+    for (auto& window : windows_)
       if (window->native() == native)
-        return window;
+        return window.get();
     return nullptr;
   }
 
-  boost::signals2::signal<void()> on_render_targets_reset;
-  boost::signals2::signal<void()> on_render_device_reset ;
+  signal<void()> on_render_targets_reset;
+  signal<void()> on_render_device_reset ;
 
 protected:
   void tick() override
   {
-    std::array<SDL_Event, 128> events;
-    int                        count ;    
-    while (SDL_PumpEvents(), count = SDL_PeepEvents(events.data(), static_cast<int>(events.size()), SDL_GETEVENT, SDL_WINDOWEVENT         , SDL_WINDOWEVENT        ), count > 0)
+    auto&       pump = sdl_event_pump::instance();
+    trace_scope window_events_scope(trace_recorder_, "window events", "dispatch");
+    const auto  window_events = pump.take(sdl_event_category::window);
+    count_events(window_events);
+    for (auto& event : window_events)
     {
-      for (auto i = 0; i < count; ++i)
+      auto  window = std::find_if(windows_.begin(), windows_.end(), [&event] (const std::unique_ptr<di::window>& iteratee)
       {
-        auto& event  = events[i];        
-        auto  window = std::find_if(windows_.begin(), windows_.end(), [&event] (const std::unique_ptr<di::window>& iteratee)
-        {
-          return iteratee->native_id() == event.window.windowID;
-        });
-        if (window == windows_.end()) // An event from an SDL window which is not handled by the display system.
-          continue;
-
-        if      (event.window.event == SDL_WINDOWEVENT_SHOWN       ) window->get()->on_visibility_change    (true );
-        else if (event.window.event == SDL_WINDOWEVENT_HIDDEN      ) window->get()->on_visibility_change    (false);
-        else if (event.window.event == SDL_WINDOWEVENT_EXPOSED     ) window->get()->on_expose               ();
-        else if (event.window.event == SDL_WINDOWEVENT_MOVED       ) window->get()->on_move                 ({std::size_t(event.window.data1), std::size_t(event.window.data2)});
-        else if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) window->get()->on_resize               ({std::size_t(event.window.data1), std::size_t(event.window.data2)});
-        else if (event.window.event == SDL_WINDOWEVENT_MINIMIZED   ) window->get()->on_minimize             ();
-        else if (event.window.event == SDL_WINDOWEVENT_MAXIMIZED   ) window->get()->on_maximize             ();
-        else if (event.window.event == SDL_WINDOWEVENT_RESTORED    ) window->get()->on_restore              ();
-        else if (event.window.event == SDL_WINDOWEVENT_ENTER       ) window->get()->on_mouse_focus_change   (true );
-        else if (event.window.event == SDL_WINDOWEVENT_LEAVE       ) window->get()->on_mouse_focus_change   (false);
-        else if (event.window.event == SDL_WINDOWEVENT_FOCUS_GAINED) window->get()->on_keyboard_focus_change(true );
-        else if (event.window.event == SDL_WINDOWEVENT_FOCUS_LOST  ) window->get()->on_keyboard_focus_change(false);
-        else if (event.window.event == SDL_WINDOWEVENT_CLOSE       ) window->get()->on_close                ();
-        else if (event.window.event == SDL_WINDOWEVENT_TAKE_FOCUS  ) window->get()->set_focus               ();
-      }
+        return iteratee->native_id() == event.window.windowID;
+      });
+      if (window == windows_.end()) // An event from an SDL window which is not handled by the display system.
+        continue;
+
+      if      (event.window.event == SDL_WINDOWEVENT_SHOWN       ) window->get()->on_visibility_change    (true );
+      else if (event.window.event == SDL_WINDOWEVENT_HIDDEN      ) window->get()->on_visibility_change    (false);
+      else if (event.window.event == SDL_WINDOWEVENT_EXPOSED     ) window->get()->on_expose               ();
+      else if (event.window.event == SDL_WINDOWEVENT_MOVED       ) window->get()->on_move                 ({std::size_t(event.window.data1), std::size_t(event.window.data2)});
+      else if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) window->get()->on_resize               ({std::size_t(event.window.data1), std::size_t(event.window.data2)});
+      else if (event.window.event == SDL_WINDOWEVENT_MINIMIZED   ) window->get()->on_minimize             ();
+      else if (event.window.event == SDL_WINDOWEVENT_MAXIMIZED   ) window->get()->on_maximize             ();
+      else if (event.window.event == SDL_WINDOWEVENT_RESTORED    ) window->get()->on_restore              ();
+      else if (event.window.event == SDL_WINDOWEVENT_ENTER       ) window->get()->on_mouse_focus_change   (true );
+      else if (event.window.event == SDL_WINDOWEVENT_LEAVE       ) window->get()->on_mouse_focus_change   (false);
+      else if (event.window.event == SDL_WINDOWEVENT_FOCUS_GAINED) window->get()->on_keyboard_focus_change(true );
+      else if (event.window.event == SDL_WINDOWEVENT_FOCUS_LOST  ) window->get()->on_keyboard_focus_change(false);
+      else if (event.window.event == SDL_WINDOWEVENT_CLOSE       ) window->get()->on_close                ();
+      else if (event.window.event == SDL_WINDOWEVENT_TAKE_FOCUS  ) window->get()->set_focus               ();
     }
-    while (SDL_PumpEvents(), count = SDL_PeepEvents(events.data(), static_cast<int>(events.size()), SDL_GETEVENT, SDL_DROPFILE            , SDL_DROPCOMPLETE       ), count > 0)
+    window_events_scope.end();
+
+    trace_scope drop_events_scope(trace_recorder_, "drop events", "dispatch");
+    const auto  drop_events = pump.take(sdl_event_category::drop);
+    count_events(drop_events);
+    for (auto& event : drop_events)
     {
-      for (auto i = 0; i < count; ++i)
+      auto  window = std::find_if(windows_.begin(), windows_.end(), [&event] (const std::unique_ptr<di::window>& iteratee)
       {
-        auto& event  = events[i];        
-        auto  window = std::find_if(windows_.begin(), windows_.end(), [&event] (const std::unique_ptr<di::window>& iteratee)
-        {
-          return iteratee->native_id() == event.drop.windowID;
-        });
-        if (window == windows_.end()) // An event from an SDL window which is not handled by the display system.
-          continue;
-
-        if      (event.type == SDL_DROPFILE    ) window->get()->on_drop_file (std::string(event.drop.file));
-        else if (event.type == SDL_DROPTEXT    ) window->get()->on_drop_text (std::string(event.drop.file));
-        else if (event.type == SDL_DROPBEGIN   ) window->get()->on_drop_start(std::string(event.drop.file));
-        else if (event.type == SDL_DROPCOMPLETE) window->get()->on_drop_end  (std::string(event.drop.file));
-
-        SDL_free(event.drop.file);
-      }
+        return iteratee->native_id() == event.drop.windowID;
+      });
+      if (window == windows_.end()) // An event from an SDL window which is not handled by the display system.
+        continue;
+
+      if      (event.type == SDL_DROPFILE    ) window->get()->on_drop_file (std::string(event.drop.file));
+      else if (event.type == SDL_DROPTEXT    ) window->get()->on_drop_text (std::string(event.drop.file));
+      else if (event.type == SDL_DROPBEGIN   ) window->get()->on_drop_start(std::string(event.drop.file));
+      else if (event.type == SDL_DROPCOMPLETE) window->get()->on_drop_end  (std::string(event.drop.file));
     }
-    while (SDL_PumpEvents(), count = SDL_PeepEvents(events.data(), static_cast<int>(events.size()), SDL_GETEVENT, SDL_RENDER_TARGETS_RESET, SDL_RENDER_DEVICE_RESET), count > 0)
+    drop_events_scope.end();
+
+    trace_scope render_events_scope(trace_recorder_, "render events", "dispatch");
+    const auto  render_events = pump.take(sdl_event_category::render);
+    count_events(render_events);
+    for (auto& event : render_events)
     {
-      for (auto i = 0; i < count; ++i)
-      {
-        auto& event = events[i];
-        if      (event.type == SDL_RENDER_TARGETS_RESET) on_render_targets_reset();
-        else if (event.type == SDL_RENDER_DEVICE_RESET ) on_render_device_reset ();
-      }
+      if      (event.type == SDL_RENDER_TARGETS_RESET) on_render_targets_reset();
+      else if (event.type == SDL_RENDER_DEVICE_RESET ) on_render_device_reset ();
     }
+    render_events_scope.end();
+
+    trace_scope update_scope(trace_recorder_, "window update", "dispatch"); // Includes buffer swaps.
     for(auto& window : windows_)
       window->update();
   }
+  // Counts the dispatched events per SDL event type into the flight recorder.
+  void count_events(const span<const SDL_Event> events)
+  {
+    if (!flight_recorder_ || !flight_recorder_->enabled()) return;
+    for (auto& event : events)
+      flight_recorder_->add(event_channels_(*flight_recorder_, event.type), 1.0);
+  }
 
-  std::vector<std::unique_ptr<window>> windows_;
+  std::vector<std::unique_ptr<window>> windows_       ;
+  flight_channel_map<Uint32>           event_channels_{"display_system/events/"};
 };
+
+template<>
+struct constructs_on_main_thread<display_system> : std::true_type { };
 }
 
 #endif
@@ -9,7 +9,6 @@
 #include <string>
 #include <utility>
 
-#include <boost/signals2.hpp>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_syswm.h>
 
@@ -23,6 +22,7 @@
 #include <di/systems/display/window_flags.hpp>
 #include <di/systems/display/window_mode.hpp>
 #include <di/utility/rectangle.hpp>
+#include <di/utility/signal.hpp>
 
 namespace di
 {
@@ -392,20 +392,20 @@ public:
   }
 #endif
 
-  boost::signals2::signal<void(bool)>                              on_visibility_change    ;
-  boost::signals2::signal<void()>                                  on_expose               ;
-  boost::signals2::signal<void(const std::array<std::size_t, 2>&)> on_move                 ;
-  boost::signals2::signal<void(const std::array<std::size_t, 2>&)> on_resize               ;
-  boost::signals2::signal<void()>                                  on_minimize             ;
-  boost::signals2::signal<void()>                                  on_maximize             ;
-  boost::signals2::signal<void()>                                  on_restore              ;
-  boost::signals2::signal<void(bool)>                              on_mouse_focus_change   ;
-  boost::signals2::signal<void(bool)>                              on_keyboard_focus_change;
-  boost::signals2::signal<void(std::string)>                       on_drop_file            ;
-  boost::signals2::signal<void(std::string)>                       on_drop_text            ;
-  boost::signals2::signal<void(std::string)>                       on_drop_start           ;
-  boost::signals2::signal<void(std::string)>                       on_drop_end             ;
-  boost::signals2::signal<void()>                                  on_close                ;
+  signal<void(bool)>                              on_visibility_change    ;
+  signal<void()>                                  on_expose               ;
+  signal<void(const std::array<std::size_t, 2>&)> on_move                 ;
+  signal<void(const std::array<std::size_t, 2>&)> on_resize               ;
+  signal<void()>                                  on_minimize             ;
+  signal<void()>                                  on_maximize             ;
+  signal<void()>                                  on_restore              ;
+  signal<void(bool)>                              on_mouse_focus_change   ;
+  signal<void(bool)>                              on_keyboard_focus_change;
+  signal<void(std::string)>                       on_drop_file            ;
+  signal<void(std::string)>                       on_drop_text            ;
+  signal<void(std::string)>                       on_drop_start           ;
+  signal<void(std::string)>                       on_drop_end             ;
+  signal<void()>                                  on_close                ;
 
 protected:
   friend SDL_HitTestResult hit_test_callback(SDL_Window*, const SDL_Point*, void*);
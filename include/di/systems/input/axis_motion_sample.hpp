@@ -0,0 +1,17 @@
+#ifndef DI_SYSTEMS_INPUT_AXIS_MOTION_SAMPLE_HPP_
+#define DI_SYSTEMS_INPUT_AXIS_MOTION_SAMPLE_HPP_
+
+#include <cstdint>
+
+namespace di
+{
+struct axis_motion_sample
+{
+  std::uint32_t timestamp; // SDL's, in milliseconds.
+  std::uint32_t device   ; // SDL joystick instance id.
+  std::uint32_t axis     ;
+  float         value    ; // In [-1, 1).
+};
+}
+
+#endif
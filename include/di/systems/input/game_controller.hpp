@@ -7,13 +7,13 @@
 #include <string>
 #include <utility>
 
-#include <boost/signals2.hpp>
 #include <SDL2/SDL_gamecontroller.h>
 
 #include <di/systems/input/game_controller_axis.hpp>
 #include <di/systems/input/game_controller_button.hpp>
 #include <di/systems/input/game_controller_default_mappings.hpp>
 #include <di/systems/input/joystick.hpp>
+#include <di/utility/signal.hpp>
 
 namespace di
 {
@@ -133,11 +133,11 @@ public:
     SDL_GameControllerUpdate();
   }
 
-  boost::signals2::signal<void(game_controller_axis, float)> on_axis_motion   ;
-  boost::signals2::signal<void(game_controller_button)>      on_button_press  ;
-  boost::signals2::signal<void(game_controller_button)>      on_button_release;
-  boost::signals2::signal<void()>                            on_remap         ;
-  boost::signals2::signal<void()>                            on_close         ;
+  signal<void(game_controller_axis, float)> on_axis_motion   ;
+  signal<void(game_controller_button)>      on_button_press  ;
+  signal<void(game_controller_button)>      on_button_release;
+  signal<void()>                            on_remap         ;
+  signal<void()>                            on_close         ;
 
 protected:
   SDL_GameController* native_    ;
@@ -170,9 +170,10 @@ public:
       }), 
       effects_.end  ());
   }
-  std::vector<haptic_effect*> haptic_effects              () const
+  template<typename allocator_type = std::allocator<haptic_effect*>>
+  std::vector<haptic_effect*, allocator_type> haptic_effects(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<haptic_effect*> haptic_effects(effects_.size());
+    std::vector<haptic_effect*, allocator_type> haptic_effects(effects_.size(), allocator);
     std::transform(
       effects_      .begin(),
       effects_      .end  (),
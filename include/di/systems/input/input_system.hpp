@@ -3,13 +3,15 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
-#include <boost/signals2.hpp>
 #include <SDL2/SDL.h>
 
 #include <di/systems/input/clipboard.hpp>
@@ -17,11 +19,19 @@
 #include <di/systems/input/game_controller.hpp>
 #include <di/systems/input/game_controller_info.hpp>
 #include <di/systems/input/haptic_device.hpp>
+#include <di/systems/input/instance_router.hpp>
 #include <di/systems/input/joystick.hpp>
 #include <di/systems/input/joystick_info.hpp>
+#include <di/systems/input/mouse_motion_coalescer.hpp>
+#include <di/systems/input/motion_sampler.hpp>
+#include <di/systems/input/sdl_event_pump.hpp>
 #include <di/systems/input/touch_device.hpp>
+#include <di/utility/flight_recorder.hpp>
+#include <di/utility/signal.hpp>
+#include <di/utility/span.hpp>
 #include <di/engine.hpp>
 #include <di/system.hpp>
+#include <di/system_traits.hpp>
 
 namespace di
 {
@@ -36,7 +46,15 @@ public:
     game_controller::set_default_mappings();
 
     for (auto i = 0; i < SDL_GetNumTouchDevices(); ++i)
-      touch_devices_.emplace_back(std::make_unique<touch_device>(SDL_GetTouchDevice(i)));
+    {
+      touch_devices_      .emplace_back(std::make_unique<touch_device>(static_cast<std::size_t>(i)));
+      touch_device_routes_.emplace_back(touch_devices_.back()->id_, touch_devices_.back().get());
+    }
+
+    // SDL event handling must run on the thread which initialized the video subsystem.
+    set_main_thread_only(true);
+    write_resource      ("input"     );
+    write_resource      ("sdl_events");
   }
   input_system           (const input_system&  that) = delete ;
   input_system           (      input_system&& temp) = delete ;
@@ -51,10 +69,12 @@ public:
   joystick*                     create_joystick        (argument_types&&... arguments)
   {
     joysticks_.emplace_back(std::make_unique<joystick>(arguments...));
+    joystick_routes_.add(static_cast<std::int32_t>(joysticks_.back()->instance_id()), joysticks_.back().get());
     return joysticks_.back().get();
   }
   void                          destroy_joystick       (joystick* joystick)
   {
+    joystick_routes_.remove(joystick);
     joysticks_.erase(std::remove_if(
       joysticks_.begin(),
       joysticks_.end  (),
@@ -64,9 +84,10 @@ public:
       }), 
       joysticks_.end  ());
   }
-  std::vector<joystick*>        joysticks              () const
+  template<typename allocator_type = std::allocator<joystick*>>
+  std::vector<joystick*, allocator_type> joysticks(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<joystick*> joysticks(joysticks_.size());
+    std::vector<joystick*, allocator_type> joysticks(joysticks_.size(), allocator);
     std::transform(
       joysticks_.begin(),
       joysticks_.end  (),
@@ -82,10 +103,12 @@ public:
   game_controller*              create_game_controller (argument_types&&... arguments)
   {
     game_controllers_.emplace_back(std::make_unique<game_controller>(arguments...));
+    game_controller_routes_.add(static_cast<std::int32_t>(game_controllers_.back()->instance_id()), game_controllers_.back().get());
     return game_controllers_.back().get();
   }
   void                          destroy_game_controller(game_controller* game_controller)
   {
+    game_controller_routes_.remove(game_controller);
     game_controllers_.erase(std::remove_if(
       game_controllers_.begin(),
       game_controllers_.end  (),
@@ -95,9 +118,10 @@ public:
       }), 
       game_controllers_.end  ());
   }
-  std::vector<game_controller*> game_controllers       () const
+  template<typename allocator_type = std::allocator<game_controller*>>
+  std::vector<game_controller*, allocator_type> game_controllers(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<game_controller*> game_controllers(game_controllers_.size());
+    std::vector<game_controller*, allocator_type> game_controllers(game_controllers_.size(), allocator);
     std::transform(
       game_controllers_.begin(),
       game_controllers_.end  (),
@@ -126,9 +150,10 @@ public:
       }), 
       haptic_devices_.end  ());
   }
-  std::vector<haptic_device*>   haptic_devices         () const
+  template<typename allocator_type = std::allocator<haptic_device*>>
+  std::vector<haptic_device*, allocator_type> haptic_devices(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<haptic_device*> haptic_devices(haptic_devices_.size());
+    std::vector<haptic_device*, allocator_type> haptic_devices(haptic_devices_.size(), allocator);
     std::transform(
       haptic_devices_.begin(),
       haptic_devices_.end  (),
@@ -140,9 +165,10 @@ public:
     return haptic_devices;
   }
 
-  std::vector<touch_device*>    touch_devices          () const
+  template<typename allocator_type = std::allocator<touch_device*>>
+  std::vector<touch_device*, allocator_type> touch_devices(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<touch_device*> touch_devices(touch_devices_.size());
+    std::vector<touch_device*, allocator_type> touch_devices(touch_devices_.size(), allocator);
     std::transform(
       touch_devices_.begin(),
       touch_devices_.end  (),
@@ -184,189 +210,302 @@ public:
       static_cast<int>(size    [1])};
     SDL_SetTextInputRect(&rectangle);
   }
+
+  // Sums the mouse motion of each window and mouse during a frame, dispatching on_mouse_move and on_mouse_move_delta once per window and
+  // mouse instead of once per motion event (see mouse_motion_coalescer). Off by default.
+  bool                          mouse_motion_coalescing    () const
+  {
+    return mouse_motion_coalescing_;
+  }
+  void                          set_mouse_motion_coalescing(const bool enabled)
+  {
+    mouse_motion_coalescing_ = enabled;
+  }
+
+  // Records every mouse motion and joystick axis sample of a frame, also when mouse motion is coalesced, into contiguous batches for
+  // consumers which process them in bulk. Off by default.
+  bool                          motion_sampling        () const
+  {
+    return motion_sampling_;
+  }
+  void                          set_motion_sampling    (const bool enabled)
+  {
+    motion_sampling_ = enabled;
+    if (!enabled)
+      motion_sampler_.clear();
+  }
+  // The samples of the last tick in order of arrival. Each tick overwrites them, so consumers which keep samples across frames copy them
+  // before the next tick.
+  span<const mouse_motion_sample> mouse_motion_samples () const
+  {
+    return motion_sampler_.mouse_motion_samples();
+  }
+  span<const axis_motion_sample>  axis_motion_samples  () const
+  {
+    return motion_sampler_.axis_motion_samples();
+  }
   
-  boost::signals2::signal<void(key)>                                   on_key_press              ;
-  boost::signals2::signal<void(key)>                                   on_key_release            ;
-  boost::signals2::signal<void(std::string, std::size_t, std::size_t)> on_text_edit              ;
-  boost::signals2::signal<void(std::string)>                           on_text_input             ;
-  boost::signals2::signal<void()>                                      on_key_layout_change      ;
-  boost::signals2::signal<void(std::array<std::int32_t, 2>)>           on_mouse_move             ;
-  boost::signals2::signal<void(std::array<std::int32_t, 2>)>           on_mouse_move_delta       ;
-  boost::signals2::signal<void(std::size_t)>                           on_mouse_press            ;
-  boost::signals2::signal<void(std::size_t)>                           on_mouse_release          ;
-  boost::signals2::signal<void(std::array<std::int32_t, 2>)>           on_mouse_wheel            ;
-  boost::signals2::signal<void(joystick_info)>                         on_joystick_connect       ;
-  boost::signals2::signal<void(game_controller_info)>                  on_game_controller_connect;
-  boost::signals2::signal<void(std::string)>                           on_clipboard_change       ;
-  boost::signals2::signal<void()>                                      on_quit                   ;
+  signal<void(key)>                                   on_key_press              ;
+  signal<void(key)>                                   on_key_release            ;
+  signal<void(std::string, std::size_t, std::size_t)> on_text_edit              ;
+  signal<void(std::string)>                           on_text_input             ;
+  signal<void()>                                      on_key_layout_change      ;
+  signal<void(std::array<std::int32_t, 2>)>           on_mouse_move             ;
+  signal<void(std::array<std::int32_t, 2>)>           on_mouse_move_delta       ;
+  signal<void(std::size_t)>                           on_mouse_press            ;
+  signal<void(std::size_t)>                           on_mouse_release          ;
+  signal<void(std::array<std::int32_t, 2>)>           on_mouse_wheel            ;
+  signal<void(joystick_info)>                         on_joystick_connect       ;
+  signal<void(game_controller_info)>                  on_game_controller_connect;
+  signal<void(std::string)>                           on_clipboard_change       ;
+  signal<void()>                                      on_quit                   ;
 
 protected:
   void initialize() override
   {
+    if (!engine_) return; // Null under a static_engine.
+
     on_quit.connect(std::bind(&engine::stop, engine_));
+
+    // An idle engine blocks on the SDL event queue, which also receives window events. Wake-ups push an event of a registered type, which
+    // the wait keeps while flushing the events nobody handles.
+    wake_event_type_ = SDL_RegisterEvents(1);
+    if (wake_event_type_ != static_cast<Uint32>(-1))
+      engine_->set_idle_source(
+      {
+        [this] (const std::chrono::milliseconds timeout) { sdl_event_pump::instance().wait(timeout, wake_event_type_); },
+        [this] ()
+        {
+          SDL_Event event {};
+          event.type = wake_event_type_;
+          SDL_PushEvent(&event);
+        }
+      });
   }
   void tick      () override
   {
-    std::array<SDL_Event, 128> events;
-    int                        count ;    
-    while (SDL_PumpEvents(), count = SDL_PeepEvents(events.data(), static_cast<int>(events.size()), SDL_GETEVENT, SDL_QUIT   , SDL_QUIT        ), count > 0)
-    {
-      for (auto i = 0; i < count; ++i)
-        on_quit();
-    }
-    while (SDL_PumpEvents(), count = SDL_PeepEvents(events.data(), static_cast<int>(events.size()), SDL_GETEVENT, SDL_KEYDOWN, SDL_DROPCOMPLETE), count > 0)
+    if (wake_event_type_ != static_cast<Uint32>(-1))
+      SDL_FlushEvent(wake_event_type_);
+
+    auto&       pump = sdl_event_pump::instance();
+    trace_scope events_scope(trace_recorder_, "input events", "dispatch");
+    const auto  quit_events = pump.take(sdl_event_category::quit);
+    count_events(quit_events);
+    if (!quit_events.empty())
+      on_quit();
+
+    const auto  events = pump.take(sdl_event_category::input);
+    count_events(events);
+    if (motion_sampling_)
+      motion_sampler_.record(events);
+    for (auto& event : events)
     {
-      for(auto i = 0; i < count; ++i)
-      {
-        auto& event = events[i];
+      // Coalesced motion is dispatched before the next button or wheel event, so that it keeps its order relative to them.
+      if (!mouse_motions_.empty() && event.type > SDL_MOUSEMOTION && event.type <= SDL_MOUSEWHEEL)
+        flush_mouse_motion();
 
-        if      (event.type == SDL_KEYDOWN                 ) on_key_press        (key{static_cast<key_code>(event.key.keysym.sym), static_cast<key_modifier>(event.key.keysym.mod), static_cast<scan_code>(event.key.keysym.scancode)});
-        else if (event.type == SDL_KEYUP                   ) on_key_release      (key{static_cast<key_code>(event.key.keysym.sym), static_cast<key_modifier>(event.key.keysym.mod), static_cast<scan_code>(event.key.keysym.scancode)});
-        else if (event.type == SDL_TEXTEDITING             ) on_text_edit        (std::string(event.edit.text), static_cast<std::size_t>(event.edit.start), static_cast<std::size_t>(event.edit.length));
-        else if (event.type == SDL_TEXTINPUT               ) on_text_input       (std::string(event.text.text));
-        else if (event.type == SDL_KEYMAPCHANGED           ) on_key_layout_change();
-        
-        else if (event.type == SDL_MOUSEMOTION             )
+      if      (event.type == SDL_KEYDOWN                 ) on_key_press        (key{static_cast<key_code>(event.key.keysym.sym), static_cast<key_modifier>(event.key.keysym.mod), static_cast<scan_code>(event.key.keysym.scancode)});
+      else if (event.type == SDL_KEYUP                   ) on_key_release      (key{static_cast<key_code>(event.key.keysym.sym), static_cast<key_modifier>(event.key.keysym.mod), static_cast<scan_code>(event.key.keysym.scancode)});
+      else if (event.type == SDL_TEXTEDITING             ) on_text_edit        (std::string(event.edit.text), static_cast<std::size_t>(event.edit.start), static_cast<std::size_t>(event.edit.length));
+      else if (event.type == SDL_TEXTINPUT               ) on_text_input       (std::string(event.text.text));
+      else if (event.type == SDL_KEYMAPCHANGED           ) on_key_layout_change();
+      
+      else if (event.type == SDL_MOUSEMOTION             )
+      {
+        if (mouse_motion_coalescing_)
+          mouse_motions_.add(event.motion.windowID, event.motion.which, {static_cast<std::int32_t>(event.motion.x), static_cast<std::int32_t>(event.motion.y)}, {static_cast<std::int32_t>(event.motion.xrel), static_cast<std::int32_t>(event.motion.yrel)});
+        else
         {
           on_mouse_move      ({static_cast<std::int32_t>(event.motion.x   ), static_cast<std::int32_t>(event.motion.y   )});
           on_mouse_move_delta({static_cast<std::int32_t>(event.motion.xrel), static_cast<std::int32_t>(event.motion.yrel)});
         }
-        else if (event.type == SDL_MOUSEBUTTONDOWN         ) on_mouse_press  ( static_cast<std::size_t>(event.button.button));
-        else if (event.type == SDL_MOUSEBUTTONUP           ) on_mouse_release( static_cast<std::size_t>(event.button.button));
-        else if (event.type == SDL_MOUSEWHEEL              ) on_mouse_wheel  ({static_cast<std::int32_t>(event.wheel.x), static_cast<std::int32_t>(event.wheel.y)});
-        
-        else if (event.type == SDL_JOYAXISMOTION           )
-        {
-          auto joystick = std::find_if(joysticks_.begin(), joysticks_.end(), [&event] (const std::unique_ptr<di::joystick>& iteratee) { return iteratee->instance_id() == event.jaxis.which; });
-          if  (joystick == joysticks_.end()) continue;
-          joystick->get()->on_axis_motion(static_cast<std::size_t>(event.jaxis.axis), static_cast<float>(event.jaxis.value) / 32768.0F);
-        }
-        else if (event.type == SDL_JOYBALLMOTION           ) 
-        {
-          auto joystick = std::find_if(joysticks_.begin(), joysticks_.end(), [&event] (const std::unique_ptr<di::joystick>& iteratee) { return iteratee->instance_id() == event.jball.which; });
-          if  (joystick == joysticks_.end()) continue;
-          joystick->get()->on_trackball_motion(static_cast<std::size_t>(event.jball.ball), {static_cast<std::int32_t>(event.jball.xrel), static_cast<std::int32_t>(event.jball.yrel)});
-        }
-        else if (event.type == SDL_JOYHATMOTION            ) 
-        {
-          auto joystick = std::find_if(joysticks_.begin(), joysticks_.end(), [&event] (const std::unique_ptr<di::joystick>& iteratee) { return iteratee->instance_id() == event.jhat.which; });
-          if  (joystick == joysticks_.end()) continue;
-          joystick->get()->on_hat_motion(static_cast<std::size_t>(event.jhat.hat), static_cast<joystick_hat_state>(event.jhat.value));
-        }
-        else if (event.type == SDL_JOYBUTTONDOWN           ) 
-        {
-          auto joystick = std::find_if(joysticks_.begin(), joysticks_.end(), [&event] (const std::unique_ptr<di::joystick>& iteratee) { return iteratee->instance_id() == event.jbutton.which; });
-          if  (joystick == joysticks_.end()) continue;
-          joystick->get()->on_button_press(static_cast<std::size_t>(event.jbutton.button));
-        }
-        else if (event.type == SDL_JOYBUTTONUP             ) 
-        {
-          auto joystick = std::find_if(joysticks_.begin(), joysticks_.end(), [&event] (const std::unique_ptr<di::joystick>& iteratee) { return iteratee->instance_id() == event.jbutton.which; });
-          if  (joystick == joysticks_.end()) continue;
-          joystick->get()->on_button_press(static_cast<std::size_t>(event.jbutton.button));
-        }
-        else if (event.type == SDL_JOYDEVICEADDED          )
-        {
-          auto joysticks = joystick_infos();
-          for (auto& joystick : joysticks)
-            if (joystick.index == event.cdevice.which)
-              on_joystick_connect(joystick);
-        }
-        else if (event.type == SDL_JOYDEVICEREMOVED        )
-        {
-          auto joystick = std::find_if(joysticks_.begin(), joysticks_.end(), [&event] (const std::unique_ptr<di::joystick>& iteratee) { return iteratee->instance_id() == event.jdevice.which; });
-          if  (joystick == joysticks_.end()) continue;
-          joystick->get()->on_close();
-        }
-        
-        else if (event.type == SDL_CONTROLLERAXISMOTION    )
-        {
-          auto game_controller = std::find_if(game_controllers_.begin(), game_controllers_.end(), [&event] (const std::unique_ptr<di::game_controller>& iteratee) { return iteratee->instance_id() == event.caxis.which; });
-          if  (game_controller == game_controllers_.end()) continue;
-          game_controller->get()->on_axis_motion(static_cast<game_controller_axis>(event.caxis.axis), static_cast<float>(event.caxis.value) / 32768.0F);
-        }
-        else if (event.type == SDL_CONTROLLERBUTTONDOWN    )
+      }
+      else if (event.type == SDL_MOUSEBUTTONDOWN         ) on_mouse_press  ( static_cast<std::size_t>(event.button.button));
+      else if (event.type == SDL_MOUSEBUTTONUP           ) on_mouse_release( static_cast<std::size_t>(event.button.button));
+      else if (event.type == SDL_MOUSEWHEEL              ) on_mouse_wheel  ({static_cast<std::int32_t>(event.wheel.x), static_cast<std::int32_t>(event.wheel.y)});
+      
+      else if (event.type == SDL_JOYAXISMOTION           )
+      {
+        joystick_routes_.route(event.jaxis.which, [&] (di::joystick* joystick)
         {
-          auto game_controller = std::find_if(game_controllers_.begin(), game_controllers_.end(), [&event] (const std::unique_ptr<di::game_controller>& iteratee) { return iteratee->instance_id() == event.cbutton.which; });
-          if  (game_controller == game_controllers_.end()) continue;
-          game_controller->get()->on_button_press(static_cast<game_controller_button>(event.cbutton.button));
-        }
-        else if (event.type == SDL_CONTROLLERBUTTONUP      )
+          joystick->on_axis_motion(static_cast<std::size_t>(event.jaxis.axis), static_cast<float>(event.jaxis.value) / 32768.0F);
+        });
+      }
+      else if (event.type == SDL_JOYBALLMOTION           ) 
+      {
+        joystick_routes_.route(event.jball.which, [&] (di::joystick* joystick)
         {
-          auto game_controller = std::find_if(game_controllers_.begin(), game_controllers_.end(), [&event] (const std::unique_ptr<di::game_controller>& iteratee) { return iteratee->instance_id() == event.cbutton.which; });
-          if  (game_controller == game_controllers_.end()) continue;
-          game_controller->get()->on_button_press(static_cast<game_controller_button>(event.cbutton.button));
-        }
-        else if (event.type == SDL_CONTROLLERDEVICEADDED   )
+          joystick->on_trackball_motion(static_cast<std::size_t>(event.jball.ball), {static_cast<std::int32_t>(event.jball.xrel), static_cast<std::int32_t>(event.jball.yrel)});
+        });
+      }
+      else if (event.type == SDL_JOYHATMOTION            ) 
+      {
+        joystick_routes_.route(event.jhat.which, [&] (di::joystick* joystick)
         {
-          auto game_controllers = game_controller_infos();
-          for (auto& game_controller : game_controllers)
-            if (game_controller.index == event.cdevice.which)
-              on_game_controller_connect(game_controller);
-        }
-        else if (event.type == SDL_CONTROLLERDEVICEREMOVED )
+          joystick->on_hat_motion(static_cast<std::size_t>(event.jhat.hat), static_cast<joystick_hat_state>(event.jhat.value));
+        });
+      }
+      else if (event.type == SDL_JOYBUTTONDOWN           ) 
+      {
+        joystick_routes_.route(event.jbutton.which, [&] (di::joystick* joystick)
         {
-          auto game_controller = std::find_if(game_controllers_.begin(), game_controllers_.end(), [&event] (const std::unique_ptr<di::game_controller>& iteratee) { return iteratee->instance_id() == event.cdevice.which; });
-          if  (game_controller == game_controllers_.end()) continue;
-          game_controller->get()->on_close();
-        }
-        else if (event.type == SDL_CONTROLLERDEVICEREMAPPED)
+          joystick->on_button_press(static_cast<std::size_t>(event.jbutton.button));
+        });
+      }
+      else if (event.type == SDL_JOYBUTTONUP             ) 
+      {
+        joystick_routes_.route(event.jbutton.which, [&] (di::joystick* joystick)
         {
-          auto game_controller = std::find_if(game_controllers_.begin(), game_controllers_.end(), [&event] (const std::unique_ptr<di::game_controller>& iteratee) { return iteratee->instance_id() == event.cdevice.which; });
-          if  (game_controller == game_controllers_.end()) continue;
-          game_controller->get()->on_remap();
-        }
-        
-        else if (event.type == SDL_FINGERDOWN              )
+          joystick->on_button_release(static_cast<std::size_t>(event.jbutton.button));
+        });
+      }
+      else if (event.type == SDL_JOYDEVICEADDED          )
+      {
+        auto joysticks = joystick_infos();
+        for (auto& joystick : joysticks)
+          if (joystick.index == event.cdevice.which)
+            on_joystick_connect(joystick);
+      }
+      else if (event.type == SDL_JOYDEVICEREMOVED        )
+      {
+        joystick_routes_.route(event.jdevice.which, [&] (di::joystick* joystick)
         {
-          auto touch_device = std::find_if(touch_devices_.begin(), touch_devices_.end(), [&event] (const std::unique_ptr<di::touch_device>& iteratee) { return iteratee->id_ == event.tfinger.touchId; });
-          if  (touch_device == touch_devices_.end()) continue;
-          touch_device->get()->on_finger_press  (finger{static_cast<std::size_t>(event.tfinger.fingerId), {event.tfinger.x , event.tfinger.y }, event.tfinger.pressure});
-        }
-        else if (event.type == SDL_FINGERUP                )
+          joystick->on_close();
+        });
+      }
+      
+      else if (event.type == SDL_CONTROLLERAXISMOTION    )
+      {
+        game_controller_routes_.route(event.caxis.which, [&] (di::game_controller* game_controller)
         {
-          auto touch_device = std::find_if(touch_devices_.begin(), touch_devices_.end(), [&event] (const std::unique_ptr<di::touch_device>& iteratee) { return iteratee->id_ == event.tfinger.touchId; });
-          if  (touch_device == touch_devices_.end()) continue;
-          touch_device->get()->on_finger_release(finger{static_cast<std::size_t>(event.tfinger.fingerId), {event.tfinger.x , event.tfinger.y }, event.tfinger.pressure});
-        }
-        else if (event.type == SDL_FINGERMOTION            )
+          game_controller->on_axis_motion(static_cast<game_controller_axis>(event.caxis.axis), static_cast<float>(event.caxis.value) / 32768.0F);
+        });
+      }
+      else if (event.type == SDL_CONTROLLERBUTTONDOWN    )
+      {
+        game_controller_routes_.route(event.cbutton.which, [&] (di::game_controller* game_controller)
         {
-          auto touch_device = std::find_if(touch_devices_.begin(), touch_devices_.end(), [&event] (const std::unique_ptr<di::touch_device>& iteratee) { return iteratee->id_ == event.tfinger.touchId; });
-          if  (touch_device == touch_devices_.end()) continue;
-          touch_device->get()->on_finger_motion (finger{static_cast<std::size_t>(event.tfinger.fingerId), {event.tfinger.dx, event.tfinger.dy}, event.tfinger.pressure});
-        }
-        else if (event.type == SDL_DOLLARGESTURE           )
+          game_controller->on_button_press(static_cast<game_controller_button>(event.cbutton.button));
+        });
+      }
+      else if (event.type == SDL_CONTROLLERBUTTONUP      )
+      {
+        game_controller_routes_.route(event.cbutton.which, [&] (di::game_controller* game_controller)
         {
-          auto touch_device = std::find_if(touch_devices_.begin(), touch_devices_.end(), [&event] (const std::unique_ptr<di::touch_device>& iteratee) { return iteratee->id_ == event.dgesture.touchId; });
-          if  (touch_device == touch_devices_.end()) continue;
-          touch_device->get()->on_gesture(gesture{event.dgesture.gestureId, {event.dgesture.x, event.dgesture.y}, event.dgesture.error, static_cast<std::size_t>(event.dgesture.numFingers)});
-        }
-        else if (event.type == SDL_DOLLARRECORD            )
+          game_controller->on_button_release(static_cast<game_controller_button>(event.cbutton.button));
+        });
+      }
+      else if (event.type == SDL_CONTROLLERDEVICEADDED   )
+      {
+        auto game_controllers = game_controller_infos();
+        for (auto& game_controller : game_controllers)
+          if (game_controller.index == event.cdevice.which)
+            on_game_controller_connect(game_controller);
+      }
+      else if (event.type == SDL_CONTROLLERDEVICEREMOVED )
+      {
+        game_controller_routes_.route(event.cdevice.which, [&] (di::game_controller* game_controller)
         {
-          auto touch_device = std::find_if(touch_devices_.begin(), touch_devices_.end(), [&event] (const std::unique_ptr<di::touch_device>& iteratee) { return iteratee->id_ == event.dgesture.touchId; });
-          if  (touch_device == touch_devices_.end()) continue;
-          touch_device->get()->record_gesture_callback_(gesture{event.dgesture.gestureId});  
-        }
-        else if (event.type == SDL_MULTIGESTURE            )
+          game_controller->on_close();
+        });
+      }
+      else if (event.type == SDL_CONTROLLERDEVICEREMAPPED)
+      {
+        game_controller_routes_.route(event.cdevice.which, [&] (di::game_controller* game_controller)
         {
-          auto touch_device = std::find_if(touch_devices_.begin(), touch_devices_.end(), [&event] (const std::unique_ptr<di::touch_device>& iteratee) { return iteratee->id_ == event.mgesture.touchId; });
-          if  (touch_device == touch_devices_.end()) continue;
-          touch_device->get()->on_multi_gesture(multi_gesture{{event.mgesture.x, event.mgesture.y}, event.mgesture.dTheta, event.mgesture.dDist, event.mgesture.numFingers});  
-        }
-        
-        else if (event.type == SDL_CLIPBOARDUPDATE         ) on_clipboard_change(clipboard::get());
+          game_controller->on_remap();
+        });
+      }
+      
+      else if (event.type == SDL_FINGERDOWN              )
+      {
+        if (const auto touch_device = route(touch_device_routes_, event.tfinger.touchId))
+          touch_device->on_finger_press  (finger{static_cast<std::size_t>(event.tfinger.fingerId), {event.tfinger.x , event.tfinger.y }, event.tfinger.pressure});
+      }
+      else if (event.type == SDL_FINGERUP                )
+      {
+        if (const auto touch_device = route(touch_device_routes_, event.tfinger.touchId))
+          touch_device->on_finger_release(finger{static_cast<std::size_t>(event.tfinger.fingerId), {event.tfinger.x , event.tfinger.y }, event.tfinger.pressure});
+      }
+      else if (event.type == SDL_FINGERMOTION            )
+      {
+        if (const auto touch_device = route(touch_device_routes_, event.tfinger.touchId))
+          touch_device->on_finger_motion (finger{static_cast<std::size_t>(event.tfinger.fingerId), {event.tfinger.dx, event.tfinger.dy}, event.tfinger.pressure});
+      }
+      else if (event.type == SDL_DOLLARGESTURE           )
+      {
+        if (const auto touch_device = route(touch_device_routes_, event.dgesture.touchId))
+          touch_device->on_gesture(gesture{event.dgesture.gestureId, {event.dgesture.x, event.dgesture.y}, event.dgesture.error, static_cast<std::size_t>(event.dgesture.numFingers)});
+      }
+      else if (event.type == SDL_DOLLARRECORD            )
+      {
+        if (const auto touch_device = route(touch_device_routes_, event.dgesture.touchId))
+          touch_device->record_gesture_callback_(gesture{event.dgesture.gestureId});  
+      }
+      else if (event.type == SDL_MULTIGESTURE            )
+      {
+        if (const auto touch_device = route(touch_device_routes_, event.mgesture.touchId))
+          touch_device->on_multi_gesture(multi_gesture{{event.mgesture.x, event.mgesture.y}, event.mgesture.dTheta, event.mgesture.dDist, event.mgesture.numFingers});  
       }
-    } 
+      
+      else if (event.type == SDL_CLIPBOARDUPDATE         ) on_clipboard_change(clipboard::get());
+    }
+    flush_mouse_motion();
+    events_scope.end();
 
+    trace_scope update_scope(trace_recorder_, "joystick update", "dispatch");
     joystick::       update_all();
     game_controller::update_all();
   }
+  void terminate () override
+  {
+    if (engine_ && wake_event_type_ != static_cast<Uint32>(-1))
+      engine_->set_idle_source({});
+  }
+  // Joysticks and game controllers are routed by instance id. Touch ids are arbitrary 64-bit values and there are few touch devices, so
+  // they are scanned in a contiguous table.
+  static touch_device* route      (const std::vector<std::pair<std::int64_t, touch_device*>>& routes, const SDL_TouchID touch_id)
+  {
+    for (auto& entry : routes)
+      if (entry.first == touch_id)
+        return entry.second;
+    return nullptr;
+  }
 
-  std::vector<std::unique_ptr<joystick>>        joysticks_       ;
-  std::vector<std::unique_ptr<game_controller>> game_controllers_;
-  std::vector<std::unique_ptr<haptic_device>>   haptic_devices_  ;
-  std::vector<std::unique_ptr<touch_device>>    touch_devices_   ;
+  void flush_mouse_motion()
+  {
+    mouse_motions_.flush([this] (const mouse_motion_coalescer::motion& motion)
+    {
+      on_mouse_move      (motion.position);
+      on_mouse_move_delta(motion.delta   );
+    });
+  }
+
+  // Counts the dispatched events per SDL event type into the flight recorder.
+  void count_events(const span<const SDL_Event> events)
+  {
+    if (!flight_recorder_ || !flight_recorder_->enabled()) return;
+    for (auto& event : events)
+      flight_recorder_->add(event_channels_(*flight_recorder_, event.type), 1.0);
+  }
+
+  std::vector<std::unique_ptr<joystick>>              joysticks_             ;
+  std::vector<std::unique_ptr<game_controller>>       game_controllers_      ;
+  std::vector<std::unique_ptr<haptic_device>>         haptic_devices_        ;
+  std::vector<std::unique_ptr<touch_device>>          touch_devices_         ;
+  instance_router<joystick>                           joystick_routes_       ;
+  instance_router<game_controller>                    game_controller_routes_;
+  std::vector<std::pair<std::int64_t, touch_device*>> touch_device_routes_   ;
+  mouse_motion_coalescer                              mouse_motions_         ;
+  bool                                                mouse_motion_coalescing_ = false;
+  bool                                                motion_sampling_       = false;
+  motion_sampler                                      motion_sampler_        ;
+  Uint32                                              wake_event_type_       = static_cast<Uint32>(-1);
+  flight_channel_map<Uint32>                          event_channels_        {"input_system/events/"};
 };
+
+template<>
+struct constructs_on_main_thread<input_system> : std::true_type { };
 }
 
 #endif
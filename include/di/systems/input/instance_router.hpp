@@ -0,0 +1,57 @@
+#ifndef DI_SYSTEMS_INPUT_INSTANCE_ROUTER_HPP_
+#define DI_SYSTEMS_INPUT_INSTANCE_ROUTER_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace di
+{
+// Instance router maps SDL joystick instance ids to the devices opened for them. SDL assigns instance ids in increasing order from zero,
+// so the routes are a table indexed by them. A joystick may be opened more than once, so each id routes to all of its devices, in order of
+// addition. SDL never reuses instance ids, so the table grows by an empty entry per device ever opened and is not shrunk when devices are
+// removed: an entry per replug, which stays small for any realistic session.
+template<typename device_type>
+class instance_router final
+{
+public:
+  // Negative (invalid) instance ids are not routed.
+  void                       add   (const std::int32_t instance_id, device_type* device)
+  {
+    if (instance_id < 0) return;
+    const auto index = static_cast<std::size_t>(instance_id);
+    if (routes_.size() <= index)
+      routes_.resize(index + 1);
+    routes_[index].push_back(device);
+  }
+  void                       remove(device_type* device)
+  {
+    for (auto& devices : routes_)
+      devices.erase(std::remove(devices.begin(), devices.end(), device), devices.end());
+  }
+  // Calls the function with each device of the instance id. The function may remove devices, e.g. close them on SDL_JOYDEVICEREMOVED.
+  template<typename function_type>
+  void                       route (const std::int32_t instance_id, function_type&& function) const
+  {
+    const auto index = static_cast<std::size_t>(static_cast<std::uint32_t>(instance_id));
+    if (index >= routes_.size()) return;
+    auto& devices = routes_[index];
+    for (std::size_t i = 0; i < devices.size(); ++i)
+    {
+      const auto device = devices[i];
+      function(device);
+      if (i >= devices.size() || devices[i] != device) // The function removed devices: go on after this one, or from its former place.
+      {
+        const auto position = std::find(devices.begin(), devices.end(), device);
+        i = position != devices.end() ? static_cast<std::size_t>(position - devices.begin()) : i - 1;
+      }
+    }
+  }
+
+private:
+  std::vector<std::vector<device_type*>> routes_; // Indexed by instance id.
+};
+}
+
+#endif
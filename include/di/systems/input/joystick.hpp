@@ -9,13 +9,13 @@
 #include <utility>
 #include <vector>
 
-#include <boost/signals2.hpp>
 #include <SDL2/SDL_joystick.h>
 
 #include <di/systems/input/haptic_device.hpp>
 #include <di/systems/input/joystick_hat_state.hpp>
 #include <di/systems/input/joystick_power_level.hpp>
 #include <di/systems/input/joystick_type.hpp>
+#include <di/utility/signal.hpp>
 
 namespace di
 {
@@ -111,16 +111,18 @@ public:
     return SDL_JoystickGetAttached(native_) != 0;
   }
                                            
-  std::vector<float>                       axes           () const
+  template<typename allocator_type = std::allocator<float>>
+  std::vector<float, allocator_type> axes(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<float> axes(SDL_JoystickNumAxes(native_));
+    std::vector<float, allocator_type> axes(SDL_JoystickNumAxes(native_), allocator);
     for(auto i = 0; i < axes.size(); ++i)
       axes[i] = static_cast<float>(SDL_JoystickGetAxis(native_, static_cast<int>(i))) / 32768.0F;
     return axes;
   }
-  std::vector<float>                       initial_axes   () const
+  template<typename allocator_type = std::allocator<float>>
+  std::vector<float, allocator_type> initial_axes(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<float> axes(SDL_JoystickNumAxes(native_));
+    std::vector<float, allocator_type> axes(SDL_JoystickNumAxes(native_), allocator);
     for (auto i = 0; i < axes.size(); ++i)
     {
       Sint16 state;
@@ -129,23 +131,26 @@ public:
     }
     return axes;
   }
-  std::vector<bool>                        buttons        () const
+  template<typename allocator_type = std::allocator<bool>>
+  std::vector<bool, allocator_type> buttons(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<bool> buttons(SDL_JoystickNumButtons(native_));
+    std::vector<bool, allocator_type> buttons(SDL_JoystickNumButtons(native_), allocator);
     for(auto i = 0; i < buttons.size(); ++i)
       buttons[i] = SDL_JoystickGetButton(native_, static_cast<int>(i)) != 0;
     return buttons;
   }
-  std::vector<joystick_hat_state>          hats           () const
+  template<typename allocator_type = std::allocator<joystick_hat_state>>
+  std::vector<joystick_hat_state, allocator_type> hats(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<joystick_hat_state> hats(SDL_JoystickNumHats(native_));
+    std::vector<joystick_hat_state, allocator_type> hats(SDL_JoystickNumHats(native_), allocator);
     for(auto i = 0; i < hats.size(); ++i)
       hats[i] = static_cast<joystick_hat_state>(SDL_JoystickGetHat(native_, static_cast<int>(i)));
     return hats;
   }
-  std::vector<std::array<std::int32_t, 2>> trackballs     () const
+  template<typename allocator_type = std::allocator<std::array<std::int32_t, 2>>>
+  std::vector<std::array<std::int32_t, 2>, allocator_type> trackballs(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<std::array<std::int32_t, 2>> trackballs(SDL_JoystickNumBalls(native_));
+    std::vector<std::array<std::int32_t, 2>, allocator_type> trackballs(SDL_JoystickNumBalls(native_), allocator);
     for (auto i = 0; i < trackballs.size(); ++i)
       SDL_JoystickGetBall(native_, static_cast<int>(i), reinterpret_cast<int*>(&trackballs[i][0]), reinterpret_cast<int*>(&trackballs[i][1]));
     return trackballs;
@@ -170,12 +175,12 @@ public:
     lock ? SDL_LockJoysticks() : SDL_UnlockJoysticks();
   }
 
-  boost::signals2::signal<void(std::size_t, float)>                       on_axis_motion     ;
-  boost::signals2::signal<void(std::size_t)>                              on_button_press    ;
-  boost::signals2::signal<void(std::size_t)>                              on_button_release  ;
-  boost::signals2::signal<void(std::size_t, joystick_hat_state)>          on_hat_motion      ;
-  boost::signals2::signal<void(std::size_t, std::array<std::int32_t, 2>)> on_trackball_motion;
-  boost::signals2::signal<void()>                                         on_close           ;
+  signal<void(std::size_t, float)>                       on_axis_motion     ;
+  signal<void(std::size_t)>                              on_button_press    ;
+  signal<void(std::size_t)>                              on_button_release  ;
+  signal<void(std::size_t, joystick_hat_state)>          on_hat_motion      ;
+  signal<void(std::size_t, std::array<std::int32_t, 2>)> on_trackball_motion;
+  signal<void()>                                         on_close           ;
 
 protected:
   friend game_controller;
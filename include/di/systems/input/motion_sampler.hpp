@@ -0,0 +1,52 @@
+#ifndef DI_SYSTEMS_INPUT_MOTION_SAMPLER_HPP_
+#define DI_SYSTEMS_INPUT_MOTION_SAMPLER_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <SDL2/SDL_events.h>
+
+#include <di/systems/input/axis_motion_sample.hpp>
+#include <di/systems/input/mouse_motion_sample.hpp>
+#include <di/utility/span.hpp>
+
+namespace di
+{
+// Motion sampler collects the mouse motion and joystick axis events of a batch of SDL events into contiguous samples, in order of arrival.
+// Each record() overwrites the samples of the previous one.
+class motion_sampler final
+{
+public:
+  void record(const span<const SDL_Event> events)
+  {
+    clear();
+    for (auto& event : events)
+    {
+      if      (event.type == SDL_MOUSEMOTION  )
+        mouse_motion_samples_.push_back({event.motion.timestamp, event.motion.which, {static_cast<std::int32_t>(event.motion.xrel), static_cast<std::int32_t>(event.motion.yrel)}});
+      else if (event.type == SDL_JOYAXISMOTION)
+        axis_motion_samples_ .push_back({event.jaxis.timestamp, static_cast<std::uint32_t>(event.jaxis.which), static_cast<std::uint32_t>(event.jaxis.axis), static_cast<float>(event.jaxis.value) / 32768.0F});
+    }
+  }
+  void clear ()
+  {
+    mouse_motion_samples_.clear();
+    axis_motion_samples_ .clear();
+  }
+
+  span<const mouse_motion_sample> mouse_motion_samples() const
+  {
+    return mouse_motion_samples_;
+  }
+  span<const axis_motion_sample>  axis_motion_samples () const
+  {
+    return axis_motion_samples_;
+  }
+
+private:
+  std::vector<mouse_motion_sample> mouse_motion_samples_;
+  std::vector<axis_motion_sample>  axis_motion_samples_ ;
+};
+}
+
+#endif
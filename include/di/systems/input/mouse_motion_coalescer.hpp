@@ -0,0 +1,54 @@
+#ifndef DI_SYSTEMS_INPUT_MOUSE_MOTION_COALESCER_HPP_
+#define DI_SYSTEMS_INPUT_MOUSE_MOTION_COALESCER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace di
+{
+// Mouse motion coalescer sums the motion of each (window, mouse) pair until it is flushed, keeping the latest position. Input system
+// flushes it before each mouse button or wheel event, so that the coalesced motion keeps its order relative to them, and at the end of each
+// frame. Keeping mice apart leaves the motion SDL emulates from touch (SDL_TOUCH_MOUSEID) out of real mouse deltas.
+class mouse_motion_coalescer final
+{
+public:
+  struct motion
+  {
+    std::uint32_t               window  ;
+    std::uint32_t               mouse   ;
+    std::array<std::int32_t, 2> position;
+    std::array<std::int32_t, 2> delta   ;
+  };
+
+  void add  (const std::uint32_t window, const std::uint32_t mouse, const std::array<std::int32_t, 2>& position, const std::array<std::int32_t, 2>& delta)
+  {
+    for (auto& motion : motions_)
+      if (motion.window == window && motion.mouse == mouse)
+      {
+        motion.position  = position;
+        motion.delta[0] += delta[0];
+        motion.delta[1] += delta[1];
+        return;
+      }
+    motions_.push_back({window, mouse, position, delta});
+  }
+  // Calls the function with each coalesced motion, in order of the first motion of each pair, and clears them.
+  template<typename function_type>
+  void flush(function_type&& function)
+  {
+    for (auto& motion : motions_)
+      function(motion);
+    motions_.clear();
+  }
+  bool empty() const
+  {
+    return motions_.empty();
+  }
+
+private:
+  std::vector<motion> motions_;
+};
+}
+
+#endif
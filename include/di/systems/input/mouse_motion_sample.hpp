@@ -0,0 +1,17 @@
+#ifndef DI_SYSTEMS_INPUT_MOUSE_MOTION_SAMPLE_HPP_
+#define DI_SYSTEMS_INPUT_MOUSE_MOTION_SAMPLE_HPP_
+
+#include <array>
+#include <cstdint>
+
+namespace di
+{
+struct mouse_motion_sample
+{
+  std::uint32_t               timestamp; // SDL's, in milliseconds.
+  std::uint32_t               device   ; // SDL mouse instance id.
+  std::array<std::int32_t, 2> delta    ;
+};
+}
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef DI_SYSTEMS_INPUT_SDL_EVENT_PUMP_HPP_
+#define DI_SYSTEMS_INPUT_SDL_EVENT_PUMP_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include <SDL2/SDL_events.h>
+#include <SDL2/SDL_stdinc.h>
+
+#include <di/utility/span.hpp>
+
+namespace di
+{
+enum class sdl_event_category
+{
+  quit       , // SDL_QUIT.
+  application, // The application lifecycle, locale and display events.
+  window     , // SDL_WINDOWEVENT.
+  input      , // Keyboard, text, mouse, joystick, game controller, touch, gesture and clipboard events, in order of arrival.
+  drop       , // SDL_DROPFILE to SDL_DROPCOMPLETE.
+  render     , // SDL_RENDER_TARGETS_RESET and SDL_RENDER_DEVICE_RESET.
+  user       , // SDL_USEREVENT and up, including the types registered with SDL_RegisterEvents.
+  other        // Everything else, e.g. SDL_SYSWMEVENT, audio device and sensor events.
+};
+
+struct sdl_event_range
+{
+  Uint32 first;
+  Uint32 last ; // Inclusive. Empty if less than first.
+};
+
+// SDL event pump drains SDL's event queue once per pass, in chunks of one SDL_PeepEvents call each, into buckets per category, so that the
+// systems handling SDL events pump and lock SDL's queue once per frame between them instead of once per event range each. The events of
+// the categories which have been taken are kept, in order of arrival; the others are dropped at each pass, so that they neither fill SDL's
+// queue nor keep an idle wait from blocking. An application which handles events of its own, e.g. user events, takes their category from
+// the pump. Taking a category which has already been taken since the last pass pumps again, so that each consumer sees each event once
+// however often it ticks. A category not taken for max_pending events is dropped at the next pass. SDL's event queue is process-wide and
+// so is the pump; like SDL event handling, it must be used on the thread which initialized the video subsystem.
+class sdl_event_pump final
+{
+public:
+  static constexpr std::size_t category_count = static_cast<std::size_t>(sdl_event_category::other) + 1;
+  static constexpr std::size_t max_pending    = 65536; // Per category, as SDL's own queue.
+
+  static sdl_event_pump& instance()
+  {
+    static sdl_event_pump pump;
+    return pump;
+  }
+
+  sdl_event_pump           (const sdl_event_pump&  that) = delete ;
+  sdl_event_pump           (      sdl_event_pump&& temp) = delete ;
+ ~sdl_event_pump           ()
+  {
+    for (std::size_t i = 0; i < category_count; ++i)
+    {
+      release(buckets_[i]);
+      release(batches_[i]);
+    }
+  }
+  sdl_event_pump& operator=(const sdl_event_pump&  that) = delete ;
+  sdl_event_pump& operator=(      sdl_event_pump&& temp) = delete ;
+
+  // Returns the events of the category which arrived since it was last taken, valid until it is taken again. The first take claims the
+  // category: from then on, its events are drained from SDL's queue at each pass. Drop event strings are owned by the pump.
+  span<const SDL_Event> take(const sdl_event_category category)
+  {
+    const auto index = static_cast<std::size_t>(category);
+    if (taken_[index] || !claimed_[index])
+    {
+      claimed_[index] = true;
+      pump();
+    }
+
+    release(batches_[index]);
+    batches_[index].swap(buckets_[index]);
+    taken_  [index] = true;
+    return batches_[index];
+  }
+
+  // Blocks until an event arrives or the timeout elapses, for an idle engine. Events of the categories nobody claimed are flushed first, as
+  // they would end the wait at once, except for events of the kept type, e.g. the one which interrupts the wait. An unclaimed event arriving
+  // during the wait still ends it, and is flushed at the next pass.
+  void wait(const std::chrono::milliseconds timeout, const Uint32 kept_type = SDL_FIRSTEVENT)
+  {
+    SDL_PumpEvents();
+    flush_unclaimed(kept_type);
+    SDL_WaitEventTimeout(nullptr, static_cast<int>(timeout.count()));
+  }
+
+  // Number of passes over SDL's queue so far.
+  std::size_t pass_count() const
+  {
+    return pass_count_;
+  }
+
+  // The event types of the category, in up to four ranges.
+  static std::array<sdl_event_range, 4> ranges    (const sdl_event_category category)
+  {
+    constexpr sdl_event_range none {1, 0};
+    switch (category)
+    {
+    case sdl_event_category::quit       : return {{{SDL_QUIT                , SDL_QUIT               }, none, none, none}};
+    case sdl_event_category::application: return {{{SDL_QUIT + 1            , SDL_WINDOWEVENT - 1    }, none, none, none}};
+    case sdl_event_category::window     : return {{{SDL_WINDOWEVENT         , SDL_WINDOWEVENT        }, none, none, none}};
+    case sdl_event_category::input      : return {{{SDL_KEYDOWN             , SDL_CLIPBOARDUPDATE    }, none, none, none}};
+    case sdl_event_category::drop       : return {{{SDL_DROPFILE            , SDL_DROPCOMPLETE       }, none, none, none}};
+    case sdl_event_category::render     : return {{{SDL_RENDER_TARGETS_RESET, SDL_RENDER_DEVICE_RESET}, none, none, none}};
+    case sdl_event_category::user       : return {{{SDL_USEREVENT           , SDL_LASTEVENT          }, none, none, none}};
+    default                             : return {{
+      {SDL_WINDOWEVENT         + 1, SDL_KEYDOWN              - 1},
+      {SDL_CLIPBOARDUPDATE     + 1, SDL_DROPFILE             - 1},
+      {SDL_DROPCOMPLETE        + 1, SDL_RENDER_TARGETS_RESET - 1},
+      {SDL_RENDER_DEVICE_RESET + 1, SDL_USEREVENT            - 1}}};
+    }
+  }
+  static sdl_event_category             categorize(const Uint32 type)
+  {
+    for (std::size_t i = 0; i < category_count; ++i)
+      for (auto& range : ranges(static_cast<sdl_event_category>(i)))
+        if (type >= range.first && type <= range.last)
+          return static_cast<sdl_event_category>(i);
+    return sdl_event_category::other;
+  }
+
+private:
+  sdl_event_pump()
+  {
+    taken_  .fill(false);
+    claimed_.fill(false);
+  }
+
+  static void release(SDL_Event& event)
+  {
+    if (event.type == SDL_DROPFILE || event.type == SDL_DROPTEXT)
+      SDL_free(event.drop.file);
+  }
+  static void release(std::vector<SDL_Event>& events)
+  {
+    for (auto& event : events)
+      release(event);
+    events.clear();
+  }
+
+  // Used by wait(), which must leave the events of the claimed categories in SDL's queue.
+  void flush_unclaimed(const Uint32 kept_type = SDL_FIRSTEVENT)
+  {
+    for (std::size_t i = 0; i < category_count; ++i)
+    {
+      if (claimed_[i]) continue;
+
+      for (auto& range : ranges(static_cast<sdl_event_category>(i)))
+      {
+        if (range.first > range.last) continue;
+        if (kept_type < range.first || kept_type > range.last)
+          SDL_FlushEvents(range.first, range.last);
+        else
+        {
+          if (kept_type > range.first) SDL_FlushEvents(range.first  , kept_type - 1);
+          if (kept_type < range.last ) SDL_FlushEvents(kept_type + 1, range.last   );
+        }
+      }
+    }
+  }
+  void pump()
+  {
+    const auto chunk_size = static_cast<int>(chunk_.size());
+
+    for (auto& bucket : buckets_)
+      if (bucket.size() >= max_pending)
+        release(bucket);
+
+    SDL_PumpEvents();
+    int count;
+    do
+    {
+      count = (std::max)(SDL_PeepEvents(chunk_.data(), chunk_size, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT), 0);
+      for (auto i = 0; i < count; ++i)
+      {
+        const auto index = static_cast<std::size_t>(categorize(chunk_[i].type));
+        if (claimed_[index])
+          buckets_[index].push_back(chunk_[i]);
+        else
+          release(chunk_[i]);
+      }
+    }
+    while (count == chunk_size);
+    taken_.fill(false);
+    ++pass_count_;
+  }
+
+  std::array<std::vector<SDL_Event>, category_count> buckets_   ; // Arrived since the last take. Reused, so that a steady state does not allocate.
+  std::array<std::vector<SDL_Event>, category_count> batches_   ; // Handed out by the last take.
+  std::array<bool, category_count>                   taken_     ;
+  std::array<bool, category_count>                   claimed_   ; // Taken at least once; only the events of claimed categories are kept.
+  std::array<SDL_Event, 128>                         chunk_     ; // One SDL_PeepEvents call.
+  std::size_t                                        pass_count_ = 0;
+};
+}
+
+#endif
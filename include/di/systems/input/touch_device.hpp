@@ -8,13 +8,13 @@
 #include <string>
 #include <vector>
 
-#include <boost/signals2.hpp>
 #include <SDL2/SDL_gesture.h>
 #include <SDL2/SDL_touch.h>
 
 #include <di/systems/input/finger.hpp>
 #include <di/systems/input/gesture.hpp>
 #include <di/systems/input/multi_gesture.hpp>
+#include <di/utility/signal.hpp>
 
 namespace di
 {
@@ -34,9 +34,10 @@ public:
   touch_device& operator=(const touch_device&  that) = default;
   touch_device& operator=(      touch_device&& temp) = default;
   
-  std::vector<finger> fingers       () const
+  template<typename allocator_type = std::allocator<finger>>
+  std::vector<finger, allocator_type> fingers(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<finger> fingers(static_cast<std::size_t>(SDL_GetNumTouchFingers(id_)));
+    std::vector<finger, allocator_type> fingers(static_cast<std::size_t>(SDL_GetNumTouchFingers(id_)), allocator);
     for(auto i = 0; i < fingers.size(); ++i)
     {
       const auto native_finger = SDL_GetTouchFinger(id_, i);
@@ -62,11 +63,11 @@ public:
     SDL_FreeRW(stream);
   }
 
-  boost::signals2::signal<void(finger)>        on_finger_press  ;
-  boost::signals2::signal<void(finger)>        on_finger_release;
-  boost::signals2::signal<void(finger)>        on_finger_motion ;
-  boost::signals2::signal<void(gesture)>       on_gesture       ;
-  boost::signals2::signal<void(multi_gesture)> on_multi_gesture ;
+  signal<void(finger)>        on_finger_press  ;
+  signal<void(finger)>        on_finger_release;
+  signal<void(finger)>        on_finger_motion ;
+  signal<void(gesture)>       on_gesture       ;
+  signal<void(multi_gesture)> on_multi_gesture ;
   
 protected:
   friend input_system;
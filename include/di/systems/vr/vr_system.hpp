@@ -2,6 +2,7 @@
 #define DI_SYSTEMS_VR_VR_SYSTEM_HPP_
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <stdexcept>
@@ -57,6 +58,12 @@ public:
       generic_tracking_devices_.emplace_back(std::make_unique<generic_tracking_device>(indices[i]));
     
     set_tracking_mode(tracking_mode);
+
+    // Compositor calls must be issued from the thread owning the graphics context.
+    set_main_thread_only(true);
+    set_continuous      (true); // The compositor expects a frame per display refresh, and OpenVR events can not be waited on.
+    write_resource      ("vr");
+    set_stage           (system_stage::render);
   }
   vr_system           (const vr_system&  that) = delete ;
   vr_system           (      vr_system&& temp) = delete ;
@@ -85,9 +92,10 @@ public:
   }
   
   // IVR System - Tracking
-  std::vector<hmd*>                     hmds                     () const
+  template<typename allocator_type = std::allocator<hmd*>>
+  std::vector<hmd*, allocator_type> hmds(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<hmd*> hmds(hmds_.size());
+    std::vector<hmd*, allocator_type> hmds(hmds_.size(), allocator);
     std::transform(
       hmds_.begin(),
       hmds_.end  (),
@@ -98,9 +106,10 @@ public:
       });
     return hmds;
   }
-  std::vector<vr_controller*>           controllers              () const
+  template<typename allocator_type = std::allocator<vr_controller*>>
+  std::vector<vr_controller*, allocator_type> controllers(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<vr_controller*> controllers(controllers_.size());
+    std::vector<vr_controller*, allocator_type> controllers(controllers_.size(), allocator);
     std::transform(
       controllers_.begin(),
       controllers_.end  (),
@@ -111,9 +120,10 @@ public:
       });
     return controllers;
   }
-  std::vector<tracking_reference*>      tracking_references      () const
+  template<typename allocator_type = std::allocator<tracking_reference*>>
+  std::vector<tracking_reference*, allocator_type> tracking_references(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<tracking_reference*> tracking_references(tracking_references_.size());
+    std::vector<tracking_reference*, allocator_type> tracking_references(tracking_references_.size(), allocator);
     std::transform(
       tracking_references_.begin(),
       tracking_references_.end  (),
@@ -124,9 +134,10 @@ public:
       });
     return tracking_references;
   }
-  std::vector<display_redirect*>        display_redirects        () const
+  template<typename allocator_type = std::allocator<display_redirect*>>
+  std::vector<display_redirect*, allocator_type> display_redirects(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<display_redirect*> display_redirects(display_redirects_.size());
+    std::vector<display_redirect*, allocator_type> display_redirects(display_redirects_.size(), allocator);
     std::transform(
       display_redirects_.begin(),
       display_redirects_.end  (),
@@ -137,9 +148,10 @@ public:
       });
     return display_redirects;
   }
-  std::vector<generic_tracking_device*> generic_tracking_devices () const
+  template<typename allocator_type = std::allocator<generic_tracking_device*>>
+  std::vector<generic_tracking_device*, allocator_type> generic_tracking_devices(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<generic_tracking_device*> generic_tracking_devices(generic_tracking_devices_.size());
+    std::vector<generic_tracking_device*, allocator_type> generic_tracking_devices(generic_tracking_devices_.size(), allocator);
     std::transform(
       generic_tracking_devices_.begin(),
       generic_tracking_devices_.end  (),
@@ -214,9 +226,10 @@ public:
       }), 
       overlays_.end  ());
   }
-  std::vector<overlay*>                 overlays                 () const
+  template<typename allocator_type = std::allocator<overlay*>>
+  std::vector<overlay*, allocator_type> overlays(const allocator_type& allocator = allocator_type()) const
   {
-    std::vector<overlay*> overlays(overlays_.size());
+    std::vector<overlay*, allocator_type> overlays(overlays_.size(), allocator);
     std::transform(
       overlays_.begin(), 
       overlays_.end  (), 
@@ -265,8 +278,9 @@ protected:
   void                                  pre_tick                 () override
   {
     // Shallow pass: Low accuracy pose predictions of the tracking devices.
+    trace_scope             scope(trace_recorder_, "predicted poses", "dispatch");
     vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
-    vr::VRSystem()->GetDeviceToAbsoluteTrackingPose(static_cast<vr::ETrackingUniverseOrigin>(tracking_mode()), hmds_.size() > 0 ? hmds()[0]->time_to_photons().count() : 0.016F, poses, vr::k_unMaxTrackedDeviceCount);
+    vr::VRSystem()->GetDeviceToAbsoluteTrackingPose(static_cast<vr::ETrackingUniverseOrigin>(tracking_mode()), hmds_.size() > 0 ? hmds_[0]->time_to_photons().count() : 0.016F, poses, vr::k_unMaxTrackedDeviceCount);
     for (auto& hmd                     : hmds_                    ) hmd                    ->pose_ = tracking_device_pose(poses[hmd                    ->index()]);
     for (auto& controller              : controllers_             ) controller             ->pose_ = tracking_device_pose(poses[controller             ->index()]);
     for (auto& tracking_reference      : tracking_references_     ) tracking_reference     ->pose_ = tracking_device_pose(poses[tracking_reference     ->index()]);
@@ -276,6 +290,7 @@ protected:
   void                                  tick                     () override
   {
     // Deep pass: High accuracy poses of the tracking devices. Freezes the calling thread. Use just prior to rendering in order to correct the eye transforms.
+    trace_scope             poses_scope(trace_recorder_, "wait get poses", "dispatch");
     vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
     vr::VRCompositor()->WaitGetPoses(poses, vr::k_unMaxTrackedDeviceCount, nullptr, 0);
     for (auto& hmd                     : hmds_                    ) hmd                    ->pose_ = tracking_device_pose(poses[hmd                    ->index()]);
@@ -284,6 +299,9 @@ protected:
     for (auto& display_redirect        : display_redirects_       ) display_redirect       ->pose_ = tracking_device_pose(poses[display_redirect       ->index()]);
     for (auto& generic_tracking_device : generic_tracking_devices_) generic_tracking_device->pose_ = tracking_device_pose(poses[generic_tracking_device->index()]);
 
+    poses_scope.end();
+
+    trace_scope   events_scope(trace_recorder_, "vr events", "dispatch");
     vr::VREvent_t event;
     while (vr::VRSystem()->PollNextEvent(&event, sizeof vr::VREvent_t))
     {
@@ -293,6 +311,31 @@ protected:
 
     for (auto& overlay : overlays_)
       overlay->process_events();
+    events_scope.end();
+
+    record_timing();
+  }
+  // Records the compositor timing of the last frame of the first HMD into the flight recorder, times in milliseconds.
+  void                                  record_timing            ()
+  {
+    if (!flight_recorder_ || !flight_recorder_->enabled() || hmds_.empty()) return;
+    if (!timing_channels_registered_)
+    {
+      static const std::array<const char*, 8> names {{"wait get poses", "present", "submit frame", "total gpu", "compositor gpu", "compositor cpu", "mispresents", "drops"}};
+      for (std::size_t i = 0; i < names.size(); ++i)
+        timing_channels_[i] = flight_recorder_->channel(std::string("vr_system/") + names[i]);
+      timing_channels_registered_ = true;
+    }
+
+    const auto timing = hmds_[0]->frame_time_data();
+    flight_recorder_->set(timing_channels_[0], timing.wait_get_poses.count());
+    flight_recorder_->set(timing_channels_[1], timing.present       .count());
+    flight_recorder_->set(timing_channels_[2], timing.submit_frame  .count());
+    flight_recorder_->set(timing_channels_[3], timing.total_gpu     .count());
+    flight_recorder_->set(timing_channels_[4], timing.compositor_gpu.count());
+    flight_recorder_->set(timing_channels_[5], timing.compositor_cpu.count());
+    flight_recorder_->set(timing_channels_[6], static_cast<double>(timing.mispresent_count));
+    flight_recorder_->set(timing_channels_[7], static_cast<double>(timing.drop_count      ));
   }
 
   std::unique_ptr<di::chaperone>                        chaperone_               ;
@@ -304,6 +347,9 @@ protected:
   std::vector<std::unique_ptr<generic_tracking_device>> generic_tracking_devices_;
 
   std::vector<std::unique_ptr<overlay>>                 overlays_                ;
+
+  std::array<std::size_t, 8>                            timing_channels_         {};
+  bool                                                  timing_channels_registered_ = false;
 };
 }
 
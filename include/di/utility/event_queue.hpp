@@ -0,0 +1,128 @@
+#ifndef DI_UTILITY_EVENT_QUEUE_HPP_
+#define DI_UTILITY_EVENT_QUEUE_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+namespace di
+{
+// Event queue is a multiple producer, single consumer queue of events. Producers post from any thread into a bounded ring without locks
+// (a compare-and-swap on the tail, then a release store of the slot's sequence), the consumer drains the ring into a batch. When the ring is
+// full, events go to an overflow vector under a mutex, which is drained once the ring has been drained up to its tail, preserving the order
+// of each producer. Events must be default constructible and move assignable.
+template<typename event_type>
+class event_queue final
+{
+public:
+  explicit event_queue  (const std::size_t capacity = 1024) : slots_(round_up(capacity)), mask_(slots_.size() - 1)
+  {
+    for (std::size_t i = 0; i < slots_.size(); ++i)
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  event_queue           (const event_queue&  that) = delete ;
+  event_queue           (      event_queue&& temp) = delete ;
+ ~event_queue           ()                         = default;
+  event_queue& operator=(const event_queue&  that) = delete ;
+  event_queue& operator=(      event_queue&& temp) = delete ;
+
+  // Thread-safe.
+  void        post          (event_type event)
+  {
+    if (!overflowing_.load(std::memory_order_acquire) && try_push(event))
+      return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    overflowing_.store(true, std::memory_order_relaxed);
+    overflow_.push_back(std::move(event));
+    ++overflow_count_;
+  }
+  // Appends the events posted so far to the batch, except those whose producers are still writing them, which come with the next drain
+  // along with the overflowed events. Single consumer.
+  void        drain         (std::vector<event_type>& batch)
+  {
+    while (true)
+    {
+      auto& slot = slots_[head_ & mask_];
+      if (slot.sequence.load(std::memory_order_acquire) != head_ + 1)
+        break;
+      batch.push_back(std::move(slot.event));
+      slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+      ++head_;
+    }
+    // While overflowing, producers post to the overflow vector, so the tail only moves for posts which were already under way.
+    if (overflowing_.load(std::memory_order_acquire) && head_ == tail_.load(std::memory_order_acquire))
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::move(overflow_.begin(), overflow_.end(), std::back_inserter(batch));
+      overflow_.clear();
+      overflowing_.store(false, std::memory_order_release);
+    }
+  }
+
+  std::size_t capacity      () const
+  {
+    return slots_.size();
+  }
+  // Number of events which did not fit the ring since the queue was created. Non-zero suggests a larger capacity.
+  std::size_t overflow_count() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return overflow_count_;
+  }
+
+private:
+  // A slot is free for the producer of position p when its sequence is p, and full for the consumer at position p when it is p + 1.
+  struct slot
+  {
+    std::atomic<std::size_t> sequence;
+    event_type               event   ;
+  };
+
+  static std::size_t round_up(const std::size_t capacity)
+  {
+    std::size_t size = 2;
+    while (size < capacity)
+      size <<= 1;
+    return size;
+  }
+
+  bool try_push(event_type& event)
+  {
+    auto position = tail_.load(std::memory_order_relaxed);
+    while (true)
+    {
+      auto&      slot       = slots_[position & mask_];
+      const auto sequence   = slot.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+      if      (difference == 0)
+      {
+        if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        {
+          slot.event = std::move(event);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (difference <  0)
+        return false;
+      else
+        position = tail_.load(std::memory_order_relaxed);
+    }
+  }
+
+  std::vector<slot>                    slots_         ;
+  std::size_t                          mask_          ;
+  alignas(64) std::atomic<std::size_t> tail_          {0};
+  alignas(64) std::size_t              head_          = 0;
+  std::atomic<bool>                    overflowing_   {false};
+  mutable std::mutex                   mutex_         ;
+  std::vector<event_type>              overflow_      ;
+  std::size_t                          overflow_count_ = 0;
+};
+}
+
+#endif
@@ -0,0 +1,347 @@
+#ifndef DI_UTILITY_FLIGHT_RECORDER_HPP_
+#define DI_UTILITY_FLIGHT_RECORDER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace di
+{
+// Flight recorder keeps named per-frame values (channels, e.g. phase times in milliseconds or event counts) of the last frames in a ring
+// buffer. When a frame takes longer than the threshold, the frames around it are captured into memory once post_frames more frames have
+// been recorded, and written to a binary dump by write_dumps(), off the frame path. Channels are registered at any time from any thread;
+// each channel must be written by one thread at a time.
+class flight_recorder final
+{
+public:
+  using duration = std::chrono::duration<double, std::milli>;
+
+  // The contents of a dump. Values are stored frame-major: value(frame, channel) = values[frame * channels.size() + channel].
+  struct dump
+  {
+    double value(const std::size_t frame, const std::size_t channel) const
+    {
+      return values[frame * channels.size() + channel];
+    }
+
+    std::uint64_t              hitch_frame = 0;
+    double                     threshold   = 0.0; // Milliseconds.
+    std::vector<std::string>   channels    ;
+    std::vector<std::uint64_t> frames      ;
+    std::vector<double>        values      ;
+  };
+
+  static constexpr std::size_t frame_time_channel = 0;
+  static constexpr std::size_t discard_channel    = (std::numeric_limits<std::size_t>::max)(); // Values added or set to it are dropped.
+
+  explicit flight_recorder  (const std::size_t frame_capacity = 120, const std::size_t channel_capacity = 256)
+  : frame_capacity_  ((std::max<std::size_t>)(frame_capacity  , 1))
+  , channel_capacity_((std::max<std::size_t>)(channel_capacity, 1))
+  , frames_          (frame_capacity_)
+  , values_          (frame_capacity_ * channel_capacity_, 0.0)
+  {
+    channels_.reserve(channel_capacity_);
+    channels_.emplace_back("frame");
+    set_post_frames(10);
+  }
+  flight_recorder           (const flight_recorder&  that) = delete ;
+  flight_recorder           (      flight_recorder&& temp) = delete ;
+ ~flight_recorder           ()                             = default;
+  flight_recorder& operator=(const flight_recorder&  that) = delete ;
+  flight_recorder& operator=(      flight_recorder&& temp) = delete ;
+
+  bool               enabled            () const
+  {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  void               set_enabled        (const bool enabled)
+  {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+  duration           threshold          () const
+  {
+    return threshold_;
+  }
+  void               set_threshold      (const duration threshold)
+  {
+    threshold_ = threshold;
+  }
+  // Frames recorded after a hitch before the dump is written. At most the frame capacity minus one.
+  std::size_t        post_frames        () const
+  {
+    return post_frames_;
+  }
+  void               set_post_frames    (const std::size_t post_frames)
+  {
+    post_frames_ = (std::min)(post_frames, frame_capacity_ - 1);
+  }
+  // Dumps are written to prefix + hitch frame index + ".difr".
+  const std::string& filename_prefix    () const
+  {
+    return filename_prefix_;
+  }
+  void               set_filename_prefix(const std::string& prefix)
+  {
+    filename_prefix_ = prefix;
+  }
+  // The files written so far. Not concurrent with write_dumps().
+  const std::vector<std::string>& dumps () const
+  {
+    return dumps_;
+  }
+  // Dumps which could not be written and have been dropped.
+  std::size_t        failure_count      () const
+  {
+    return failure_count_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the channel of the name, registering it if necessary. Returns discard_channel once the channel capacity is exhausted, as
+  // channels may be registered on the frame path.
+  std::size_t channel(const std::string_view name)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto iterator = std::find(channels_.begin(), channels_.end(), name);
+    if (iterator != channels_.end())
+      return static_cast<std::size_t>(iterator - channels_.begin());
+    if (channels_.size() == channel_capacity_)
+      return discard_channel;
+    channels_.emplace_back(name);
+    return channels_.size() - 1;
+  }
+  // Values recorded before the first frame are dropped.
+  void        add    (const std::size_t channel, const double value)
+  {
+    if (count_ > 0 && channel != discard_channel) values_[row() + channel] += value;
+  }
+  void        set    (const std::size_t channel, const double value)
+  {
+    if (count_ > 0 && channel != discard_channel) values_[row() + channel]  = value;
+  }
+
+  void begin_frame(const std::uint64_t frame_index)
+  {
+    ++count_;
+    frames_[(count_ - 1) % frame_capacity_] = frame_index;
+    std::fill_n(values_.begin() + row(), channel_capacity_, 0.0);
+  }
+  // Sets the frame time and captures a dump if one is due. Hitches within the frames of a pending dump are part of it. Returns whether a
+  // dump has been captured, which is then to be written by write_dumps().
+  bool end_frame  (const duration frame_time)
+  {
+    set(frame_time_channel, frame_time.count());
+    if (!dump_pending_ && frame_time > threshold_)
+    {
+      dump_pending_ = true;
+      hitch_frame_  = frames_[(count_ - 1) % frame_capacity_];
+      remaining_    = post_frames_;
+    }
+    else if (dump_pending_)
+      --remaining_;
+
+    if (!dump_pending_ || remaining_ != 0)
+      return false;
+    capture();
+    return true;
+  }
+  // Captures the pending dump, if any, without waiting for its remaining post frames, and writes the captured dumps.
+  void flush      ()
+  {
+    if (dump_pending_)
+      capture();
+    write_dumps();
+  }
+  // Writes the captured dumps to their files. Thread-safe, so that it may run on a worker while the frames go on. A dump which cannot be
+  // written is counted in failure_count() and dropped.
+  void write_dumps()
+  {
+    std::vector<captured_dump> captures;
+    {
+      std::lock_guard<std::mutex> lock(dumps_mutex_);
+      captures.swap(captures_);
+    }
+    for (auto& capture : captures)
+    {
+      std::ofstream stream(capture.filename, std::ios::binary);
+      stream.write(capture.bytes.data(), static_cast<std::streamsize>(capture.bytes.size()));
+      stream.close();
+
+      std::lock_guard<std::mutex> lock(dumps_mutex_);
+      if (stream)
+        dumps_.push_back(std::move(capture.filename));
+      else
+        failure_count_.fetch_add(1, std::memory_order_relaxed);
+      capture.bytes.clear();
+      spare_buffers_.push_back(std::move(capture.bytes));
+    }
+  }
+  void clear      ()
+  {
+    count_        = 0;
+    dump_pending_ = false;
+  }
+
+  // Writes the recorded frames, oldest first. Not concurrent with recording.
+  void        write(std::ostream& stream, const std::uint64_t hitch_frame) const
+  {
+    serialize(hitch_frame, [&stream] (const char* data, const std::size_t size) { stream.write(data, static_cast<std::streamsize>(size)); });
+  }
+  static dump read (std::istream& stream)
+  {
+    char identifier[sizeof magic];
+    stream.read(identifier, sizeof identifier);
+    if (!stream || std::memcmp(identifier, magic, sizeof magic) != 0 || read_value<std::uint32_t>(stream) != version)
+      throw std::runtime_error("Not a flight recorder dump of version " + std::to_string(version) + ".");
+
+    dump dump;
+    dump.hitch_frame = read_value<std::uint64_t>(stream);
+    dump.threshold   = read_value<double>       (stream);
+    dump.channels.resize(read_value<std::uint32_t>(stream));
+    for (auto& channel : dump.channels)
+    {
+      channel.resize(read_value<std::uint32_t>(stream));
+      stream.read(&channel[0], static_cast<std::streamsize>(channel.size()));
+    }
+    dump.frames.resize(read_value<std::uint32_t>(stream));
+    dump.values.resize(dump.frames.size() * dump.channels.size());
+    for (std::size_t i = 0; i < dump.frames.size(); ++i)
+    {
+      dump.frames[i] = read_value<std::uint64_t>(stream);
+      stream.read(reinterpret_cast<char*>(dump.values.data() + i * dump.channels.size()), static_cast<std::streamsize>(dump.channels.size() * sizeof(double)));
+    }
+    if (!stream)
+      throw std::runtime_error("Truncated flight recorder dump.");
+    return dump;
+  }
+
+private:
+  static constexpr char          magic[4] = {'D', 'I', 'F', 'R'};
+  static constexpr std::uint32_t version  = 1;
+
+  struct captured_dump
+  {
+    std::string filename;
+    std::string bytes   ;
+  };
+
+  // Dumps are in the byte order of the machine which wrote them.
+  template<typename sink_type>
+  void        serialize  (const std::uint64_t hitch_frame, const sink_type& sink) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto first = count_ > frame_capacity_ ? count_ - frame_capacity_ : std::uint64_t(0);
+
+    sink(magic, sizeof magic);
+    write_value(sink, version);
+    write_value(sink, hitch_frame);
+    write_value(sink, threshold_.count());
+    write_value(sink, static_cast<std::uint32_t>(channels_.size()));
+    for (auto& channel : channels_)
+    {
+      write_value(sink, static_cast<std::uint32_t>(channel.size()));
+      sink(channel.data(), channel.size());
+    }
+    write_value(sink, static_cast<std::uint32_t>(count_ - first));
+    for (auto i = first; i < count_; ++i)
+    {
+      const auto slot = static_cast<std::size_t>(i % frame_capacity_);
+      write_value(sink, frames_[slot]);
+      sink(reinterpret_cast<const char*>(values_.data() + slot * channel_capacity_), channels_.size() * sizeof(double));
+    }
+  }
+  template<typename sink_type, typename type>
+  static void write_value(const sink_type& sink, const type& value)
+  {
+    sink(reinterpret_cast<const char*>(&value), sizeof value);
+  }
+  template<typename type>
+  static type read_value (std::istream& stream)
+  {
+    type value {};
+    stream.read(reinterpret_cast<char*>(&value), sizeof value);
+    return value;
+  }
+
+  // Copies the pending dump into a buffer, reusing those of the dumps written so far, as the ring buffer is overwritten by the next frames.
+  void capture()
+  {
+    dump_pending_ = false;
+    std::string bytes;
+    {
+      std::lock_guard<std::mutex> lock(dumps_mutex_);
+      if (!spare_buffers_.empty())
+      {
+        bytes = std::move(spare_buffers_.back());
+        spare_buffers_.pop_back();
+      }
+    }
+    serialize(hitch_frame_, [&bytes] (const char* data, const std::size_t size) { bytes.append(data, size); });
+
+    std::lock_guard<std::mutex> lock(dumps_mutex_);
+    captures_.push_back(captured_dump {filename_prefix_ + std::to_string(hitch_frame_) + ".difr", std::move(bytes)});
+  }
+
+  std::size_t row() const
+  {
+    return static_cast<std::size_t>((count_ - 1) % frame_capacity_) * channel_capacity_;
+  }
+
+  std::size_t                frame_capacity_  ;
+  std::size_t                channel_capacity_;
+  std::atomic<bool>          enabled_         {false};
+  duration                   threshold_       {50.0};
+  std::size_t                post_frames_     = 0;
+  std::string                filename_prefix_ = "hitch_";
+  mutable std::mutex         mutex_           ;
+  std::vector<std::string>   channels_        ; // Reserved to the capacity, so that registering does not move the names.
+  std::vector<std::uint64_t> frames_          ;
+  std::vector<double>        values_          ; // Frame capacity rows of channel capacity values.
+  std::uint64_t              count_           = 0; // Frames begun.
+  bool                       dump_pending_    = false;
+  std::uint64_t              hitch_frame_     = 0;
+  std::size_t                remaining_       = 0;
+  mutable std::mutex         dumps_mutex_     ; // Guards the captures, the dumps and the spare buffers.
+  std::vector<captured_dump> captures_        ;
+  std::vector<std::string>   dumps_           ;
+  std::vector<std::string>   spare_buffers_   ;
+  std::atomic<std::size_t>   failure_count_   {0};
+};
+
+// Maps keys (e.g. event types) to channels named prefix + key, registering each channel on first use. Not thread-safe.
+template<typename key_type>
+class flight_channel_map
+{
+public:
+  explicit flight_channel_map(std::string prefix) : prefix_(std::move(prefix))
+  {
+
+  }
+
+  std::size_t operator()(flight_recorder& recorder, const key_type key)
+  {
+    const auto iterator = std::find_if(channels_.begin(), channels_.end(), [&key] (const std::pair<key_type, std::size_t>& entry) { return entry.first == key; });
+    if (iterator != channels_.end())
+      return iterator->second;
+    channels_.emplace_back(key, recorder.channel(prefix_ + std::to_string(key)));
+    return channels_.back().second;
+  }
+
+private:
+  std::string                                   prefix_  ;
+  std::vector<std::pair<key_type, std::size_t>> channels_;
+};
+}
+
+#endif
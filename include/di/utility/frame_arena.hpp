@@ -0,0 +1,126 @@
+#ifndef DI_UTILITY_FRAME_ARENA_HPP_
+#define DI_UTILITY_FRAME_ARENA_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace di
+{
+// Frame arena is a linear (bump) memory resource for allocations which live until the next reset(), typically the end of a frame.
+// Allocation is a lock-free pointer bump, deallocation is a no-op. When the block runs out, allocations fall back to the upstream
+// resource; the next reset() then grows the block to the peak usage, so that a steady state allocates nothing from upstream.
+class frame_arena final : public std::pmr::memory_resource
+{
+public:
+  explicit frame_arena  (const std::size_t capacity = 1 << 20, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+  : upstream_(upstream)
+  {
+    allocate_block(capacity);
+  }
+  frame_arena           (const frame_arena&  that) = delete ;
+  frame_arena           (      frame_arena&& temp) = delete ;
+ ~frame_arena           () override
+  {
+    release_overflow();
+    upstream_->deallocate(block_, capacity_, alignof(std::max_align_t));
+  }
+  frame_arena& operator=(const frame_arena&  that) = delete ;
+  frame_arena& operator=(      frame_arena&& temp) = delete ;
+
+  // Invalidates all allocations. Must not overlap with allocation.
+  void        reset         ()
+  {
+    const auto required = offset_.load(std::memory_order_relaxed) + overflow_size_;
+    peak_size_ = (std::max)(peak_size_, required);
+    release_overflow();
+    if (peak_size_ > capacity_)
+    {
+      upstream_->deallocate(block_, capacity_, alignof(std::max_align_t));
+      allocate_block(peak_size_ + peak_size_ / 2);
+    }
+    offset_.store(0, std::memory_order_relaxed);
+  }
+
+  std::size_t capacity      () const
+  {
+    return capacity_;
+  }
+  // Bytes allocated since the last reset, including alignment padding and upstream fallbacks.
+  std::size_t size          () const
+  {
+    return (std::min)(offset_.load(std::memory_order_relaxed), capacity_) + overflow_size_;
+  }
+  // Number of allocations which fell back to the upstream resource since the arena was created.
+  std::size_t overflow_count() const
+  {
+    return overflow_count_;
+  }
+
+protected:
+  void* do_allocate  (const std::size_t bytes, const std::size_t alignment) override
+  {
+    auto offset = offset_.load(std::memory_order_relaxed);
+    while (true)
+    {
+      const auto address = (reinterpret_cast<std::uintptr_t>(block_) + offset + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+      const auto end     = address - reinterpret_cast<std::uintptr_t>(block_) + bytes;
+      if (end > capacity_)
+        break;
+      if (offset_.compare_exchange_weak(offset, end, std::memory_order_relaxed))
+        return reinterpret_cast<void*>(address);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    overflow_.push_back(allocation {upstream_->allocate(bytes, alignment), bytes, alignment});
+    overflow_size_ += bytes;
+    ++overflow_count_;
+    return overflow_.back().pointer;
+  }
+  void  do_deallocate(void*, std::size_t, std::size_t) override // Allocations are released all at once by reset().
+  {
+
+  }
+  bool  do_is_equal  (const std::pmr::memory_resource& that) const noexcept override
+  {
+    return this == &that;
+  }
+
+private:
+  struct allocation
+  {
+    void*       pointer  ;
+    std::size_t bytes    ;
+    std::size_t alignment;
+  };
+
+  void allocate_block  (const std::size_t capacity)
+  {
+    capacity_ = (std::max<std::size_t>)(capacity, 1);
+    block_    = static_cast<std::byte*>(upstream_->allocate(capacity_, alignof(std::max_align_t)));
+  }
+  void release_overflow()
+  {
+    for (auto& allocation : overflow_)
+      upstream_->deallocate(allocation.pointer, allocation.bytes, allocation.alignment);
+    overflow_.clear();
+    overflow_size_ = 0;
+  }
+
+  std::pmr::memory_resource* upstream_       ;
+  std::byte*                 block_          = nullptr;
+  std::size_t                capacity_       = 0;
+  std::atomic<std::size_t>   offset_         {0};
+  std::size_t                peak_size_      = 0;
+  std::mutex                 mutex_          ;
+  std::vector<allocation>    overflow_       ;
+  std::size_t                overflow_size_  = 0;
+  std::size_t                overflow_count_ = 0;
+};
+}
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef DI_UTILITY_FRAME_LIMITER_HPP_
+#define DI_UTILITY_FRAME_LIMITER_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+
+namespace di
+{
+// Frame limiter paces consecutive calls to wait() to a target frame rate. It sleeps until shortly before the deadline and spins for the
+// remainder, trading a fraction of a core for sub-millisecond precision. Deadlines advance by whole periods so that errors do not accumulate.
+class frame_limiter final
+{
+public:
+  using clock      = std::chrono::steady_clock;
+  using duration   = std::chrono::duration<double, std::milli>;
+  using time_point = clock::time_point;
+
+  // Error is the difference between the wake-up time and the deadline, over the frames which arrived early enough to wait.
+  struct pacing_statistics
+  {
+    std::size_t frame_count  = 0;
+    std::size_t missed_count = 0; // Deadlines passed before the frame arrived, including the whole periods skipped by a late frame.
+    duration    mean_error   {0.0};
+    duration    max_error    {0.0};
+    duration    jitter       {0.0}; // Standard deviation of the error.
+  };
+
+  explicit frame_limiter  (const double frame_rate = 0.0, const duration spin_threshold = duration(1.5)) : spin_threshold_(spin_threshold)
+  {
+    set_target_frame_rate(frame_rate);
+  }
+  frame_limiter           (const frame_limiter&  that) = default;
+  frame_limiter           (      frame_limiter&& temp) = default;
+ ~frame_limiter           ()                           = default;
+  frame_limiter& operator=(const frame_limiter&  that) = default;
+  frame_limiter& operator=(      frame_limiter&& temp) = default;
+
+  void wait()
+  {
+    if (period_ == clock::duration::zero()) return;
+
+    auto now = clock::now();
+    if (deadline_ == time_point()) // First frame.
+    {
+      deadline_ = now + period_;
+      return;
+    }
+    if (now > deadline_ + period_) // More than a frame behind: count the frame and the periods it skipped as missed, and resynchronize instead of bursting.
+    {
+      statistics_.missed_count += 1 + static_cast<std::size_t>((now - deadline_) / period_);
+      deadline_ = now + period_;
+      return;
+    }
+    if (now > deadline_)
+    {
+      ++statistics_.missed_count;
+      deadline_ += period_;
+      return;
+    }
+
+    if (deadline_ - now > spin_threshold_)
+      std::this_thread::sleep_until(deadline_ - std::chrono::duration_cast<clock::duration>(spin_threshold_));
+    while ((now = clock::now()) < deadline_)
+      ;
+
+    record(now - deadline_);
+    deadline_ += period_;
+  }
+  void reset()
+  {
+    deadline_   = time_point();
+    statistics_ = pacing_statistics();
+    m2_         = 0.0;
+  }
+
+  double                   target_frame_rate    () const
+  {
+    return frame_rate_;
+  }
+  // Zero disables pacing. The limiter does not query displays; callers convert refresh rates themselves, e.g.
+  // set_target_frame_rate(static_cast<double>(mode.refresh_rate)) or set_target_frame_rate(hmd.display_frequency()). SDL reports an unknown
+  // refresh rate as zero, which disables pacing.
+  void                     set_target_frame_rate(const double frame_rate)
+  {
+    frame_rate_ = (std::max)(frame_rate, 0.0);
+    period_     = frame_rate_ > 0.0 ? std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / frame_rate_)) : clock::duration::zero();
+    deadline_   = time_point();
+  }
+  duration                 spin_threshold       () const
+  {
+    return spin_threshold_;
+  }
+  void                     set_spin_threshold   (const duration spin_threshold)
+  {
+    spin_threshold_ = spin_threshold;
+  }
+  const pacing_statistics& statistics           () const
+  {
+    return statistics_;
+  }
+
+private:
+  void record(const duration error)
+  {
+    // Welford's online algorithm.
+    const auto delta = error - statistics_.mean_error;
+    ++statistics_.frame_count;
+    statistics_.mean_error += delta / static_cast<double>(statistics_.frame_count);
+    m2_                    += delta.count() * (error - statistics_.mean_error).count();
+    statistics_.max_error   = (std::max)(statistics_.max_error, error);
+    statistics_.jitter      = duration(std::sqrt(m2_ / static_cast<double>(statistics_.frame_count)));
+  }
+
+  double            frame_rate_     = 0.0;
+  clock::duration   period_         = clock::duration::zero();
+  duration          spin_threshold_ ;
+  time_point        deadline_       ;
+  pacing_statistics statistics_     ;
+  double            m2_             = 0.0;
+};
+}
+
+#endif
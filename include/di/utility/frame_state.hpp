@@ -0,0 +1,50 @@
+#ifndef DI_UTILITY_FRAME_STATE_HPP_
+#define DI_UTILITY_FRAME_STATE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace di
+{
+// Frame state keeps one copy of a type per frame in flight, indexed by frame index. With a pipelined engine, simulation systems write
+// the slot of the frame they simulate while render systems read the slot of the (older) frame they present, without locking.
+template<typename type>
+class frame_state final
+{
+public:
+  explicit frame_state  (const std::size_t depth = 1) : slots_((std::max<std::size_t>)(depth, 1))
+  {
+
+  }
+  frame_state           (const frame_state&  that) = default;
+  frame_state           (      frame_state&& temp) = default;
+ ~frame_state           ()                         = default;
+  frame_state& operator=(const frame_state&  that) = default;
+  frame_state& operator=(      frame_state&& temp) = default;
+
+  type&       operator[](const std::size_t frame_index)
+  {
+    return slots_[frame_index % slots_.size()];
+  }
+  const type& operator[](const std::size_t frame_index) const
+  {
+    return slots_[frame_index % slots_.size()];
+  }
+
+  // Typically called with engine::pipeline_depth() in initialize().
+  void        resize    (const std::size_t depth)
+  {
+    slots_.resize((std::max<std::size_t>)(depth, 1));
+  }
+  std::size_t depth     () const
+  {
+    return slots_.size();
+  }
+
+private:
+  std::vector<type> slots_;
+};
+}
+
+#endif
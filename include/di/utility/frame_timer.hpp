@@ -1,20 +1,47 @@
 #ifndef DI_UTILITY_FRAME_TIMER_HPP_
 #define DI_UTILITY_FRAME_TIMER_HPP_
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <di/utility/timing_histogram.hpp>
 
 namespace di
 {
-// Frame timer keeps track of time and the delta between two consecutive calls to tick().
-template<typename representation = double, typename precision = std::milli>
+struct frame_statistics
+{
+  using duration = std::chrono::duration<double, std::milli>;
+
+  std::size_t count              = 0;
+  duration    mean               {0.0};
+  duration    standard_deviation {0.0};
+  duration    jitter             {0.0}; // Mean absolute difference of consecutive frame times.
+  duration    p50                {0.0};
+  duration    p95                {0.0};
+  duration    p99                {0.0};
+};
+
+// Frame timer keeps track of time and the delta between two consecutive calls to tick(). The clock is a policy: std::chrono::steady_clock
+// by default, or e.g. di::tsc_clock for cheaper reads. Optionally keeps rolling statistics of the last window_size frame times, updated in
+// constant time per tick (percentiles from a log-linear histogram, within 12.5%).
+template<typename representation = double, typename precision = std::milli, typename clock_type = std::chrono::steady_clock>
 class frame_timer final
 {
 public:
-  using clock      = std::chrono::high_resolution_clock;
+  using clock      = clock_type;
   using duration   = std::chrono::duration<representation, precision>;
   using time_point = std::chrono::time_point<clock, duration>;
 
-  frame_timer           () : time_(clock::now()) { }
+  static_assert(clock::is_steady, "Frame timer requires a steady clock.");
+
+  explicit frame_timer  (const std::size_t window_size = 0) : time_(clock::now())
+  {
+    set_window_size(window_size);
+  }
   frame_timer           (const frame_timer&  that) = default;
   frame_timer           (      frame_timer&& temp) = default;
  ~frame_timer           ()                         = default;
@@ -23,9 +50,12 @@ public:
 
   void tick()
   {
-    auto time   = clock::now();
-    delta_time_ = time - time_;
+    const auto time  = clock::now();
+    const auto delta = time - time_; // In the clock's own representation, so that long run times do not cost precision.
+    delta_time_ = std::chrono::duration_cast<duration>(delta);
     time_       = time;
+    if (!samples_.empty())
+      record(std::chrono::duration<double, std::nano>(delta).count());
   }
 
   duration   delta_time() const
@@ -34,12 +64,101 @@ public:
   }
   time_point time      () const
   {
-    return time_;
+    return std::chrono::time_point_cast<duration>(time_);
+  }
+
+  // Zero (default) disables the statistics. Resets them.
+  void             set_window_size (const std::size_t window_size)
+  {
+    samples_      .assign(window_size, 0.0);
+    bucket_counts_.assign(window_size > 0 ? timing_histogram::bucket_count : 0, 0);
+    reset_statistics();
+  }
+  std::size_t      window_size     () const
+  {
+    return samples_.size();
+  }
+  void             reset_statistics()
+  {
+    std::fill(bucket_counts_.begin(), bucket_counts_.end(), 0);
+    count_      = 0;
+    mean_       = 0.0;
+    m2_         = 0.0;
+    jitter_sum_ = 0.0;
+  }
+  frame_statistics statistics      () const
+  {
+    using milliseconds = frame_statistics::duration;
+
+    frame_statistics statistics;
+    statistics.count = static_cast<std::size_t>((std::min<std::uint64_t>)(count_, samples_.size()));
+    if (statistics.count == 0)
+      return statistics;
+
+    statistics.mean               = std::chrono::duration_cast<milliseconds>(std::chrono::duration<double, std::nano>(mean_));
+    statistics.standard_deviation = std::chrono::duration_cast<milliseconds>(std::chrono::duration<double, std::nano>(
+      statistics.count > 1 ? std::sqrt((std::max)(m2_, 0.0) / static_cast<double>(statistics.count - 1)) : 0.0));
+    statistics.jitter             = std::chrono::duration_cast<milliseconds>(std::chrono::duration<double, std::nano>(
+      statistics.count > 1 ? (std::max)(jitter_sum_, 0.0) / static_cast<double>(statistics.count - 1) : 0.0));
+    statistics.p50                = percentile(statistics.count, 0.50);
+    statistics.p95                = percentile(statistics.count, 0.95);
+    statistics.p99                = percentile(statistics.count, 0.99);
+    return statistics;
   }
 
 private:
-  duration   delta_time_;
-  time_point time_      ;
+  // Sliding Welford update of the mean and the sum of squared deviations, plus the running sum of consecutive differences.
+  void                         record    (const double sample)
+  {
+    const auto size  = samples_.size();
+    const auto index = static_cast<std::size_t>(count_ % size);
+    if (count_ > 0)
+      jitter_sum_ += std::abs(sample - samples_[(index + size - 1) % size]);
+
+    if (count_ < size)
+    {
+      const auto count = static_cast<double>(count_ + 1);
+      const auto delta = sample - mean_;
+      mean_ += delta / count;
+      m2_   += delta * (sample - mean_);
+    }
+    else
+    {
+      const auto evicted = samples_[index];
+      if (size > 1)
+        jitter_sum_ -= std::abs(samples_[(index + 1) % size] - evicted);
+      const auto mean = mean_ + (sample - evicted) / static_cast<double>(size);
+      m2_   += (sample - evicted) * (sample - mean + evicted - mean_);
+      mean_  = mean;
+      --bucket_counts_[timing_histogram::bucket_index(static_cast<std::uint64_t>(evicted))];
+    }
+
+    samples_[index] = sample;
+    ++bucket_counts_[timing_histogram::bucket_index(static_cast<std::uint64_t>(sample))];
+    ++count_;
+  }
+  frame_statistics::duration   percentile(const std::size_t count, const double fraction) const
+  {
+    const auto    target     = (std::max<std::uint64_t>)(static_cast<std::uint64_t>(fraction * static_cast<double>(count) + 0.5), 1);
+    std::uint64_t cumulative = 0;
+    auto          bucket     = bucket_counts_.size() - 1;
+    for (std::size_t i = 0; i < bucket_counts_.size(); ++i)
+      if ((cumulative += bucket_counts_[i]) >= target)
+      {
+        bucket = i;
+        break;
+      }
+    return std::chrono::duration_cast<frame_statistics::duration>(std::chrono::nanoseconds(timing_histogram::bucket_value(bucket)));
+  }
+
+  duration                     delta_time_   {0};
+  typename clock::time_point   time_         ;
+  std::vector<double>          samples_      ; // Frame times in nanoseconds, a ring buffer of window_size.
+  std::vector<std::uint32_t>   bucket_counts_;
+  std::uint64_t                count_        = 0;
+  double                       mean_         = 0.0;
+  double                       m2_           = 0.0;
+  double                       jitter_sum_   = 0.0;
 };
 }
 
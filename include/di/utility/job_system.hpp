@@ -0,0 +1,266 @@
+#ifndef DI_UTILITY_JOB_SYSTEM_HPP_
+#define DI_UTILITY_JOB_SYSTEM_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <di/utility/thread_pool.hpp>
+#include <di/utility/tsc_clock.hpp>
+
+namespace di
+{
+// Job system lets code fan work out over the workers of a thread pool, through parallel_for and task groups. Waiting threads run pending
+// jobs instead of blocking, so jobs may wait on jobs. Without a thread pool (e.g. an engine with zero workers), jobs run on the calling
+// thread. The time threads spend waiting for jobs of other threads is accumulated until taken.
+class job_system final
+{
+public:
+  explicit job_system  (di::thread_pool* thread_pool = nullptr) : thread_pool_(thread_pool)
+  {
+
+  }
+  job_system           (const job_system&  that) = delete ;
+  job_system           (      job_system&& temp) = delete ;
+ ~job_system           ()                        = default;
+  job_system& operator=(const job_system&  that) = delete ;
+  job_system& operator=(      job_system&& temp) = delete ;
+
+  // Calls function(i) for each i in [begin, end), in chunks of grain_size claimed by the calling thread and the workers. Returns once all
+  // calls have completed, rethrowing the first exception thrown by them.
+  template<typename function_type>
+  void parallel_for(const std::size_t begin, const std::size_t end, const std::size_t grain_size, const function_type& function)
+  {
+    if (begin >= end) return;
+
+    const auto grain_count  = (end - begin + (std::max<std::size_t>)(grain_size, 1) - 1) / (std::max<std::size_t>)(grain_size, 1);
+    const auto helper_count = thread_pool_ ? (std::min)(grain_count - 1, thread_pool_->worker_count()) : std::size_t(0);
+    if (helper_count == 0)
+    {
+      for (auto i = begin; i < end; ++i)
+        function(i);
+      return;
+    }
+
+    // Helpers capture a single pointer, which std::function stores without allocating.
+    range_state state;
+    state.context     = &function;
+    state.call        = [ ] (const void* context, const std::size_t index) { (*static_cast<const function_type*>(context))(index); };
+    state.begin       = begin;
+    state.end         = end;
+    state.grain_size  = (std::max<std::size_t>)(grain_size, 1);
+    state.grain_count = grain_count;
+    state.helpers     .store(helper_count, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < helper_count; ++i)
+      thread_pool_->submit([state = &state]
+      {
+        state->run();
+        state->helpers.fetch_sub(1, std::memory_order_release);
+      });
+    state.run();
+    wait([&state] { return state.helpers.load(std::memory_order_acquire) == 0; });
+
+    if (state.exception)
+      std::rethrow_exception(state.exception);
+  }
+
+  // Runs pending jobs on the calling thread until the condition holds. The time spent, including the jobs run meanwhile, is job wait time.
+  template<typename condition_type>
+  void wait(const condition_type& condition)
+  {
+    if (condition()) return;
+
+    const auto start = tsc_clock::ticks();
+    while (!condition())
+      if (!thread_pool_ || !thread_pool_->run_one())
+        std::this_thread::yield();
+    wait_ticks_.fetch_add(tsc_clock::ticks() - start, std::memory_order_relaxed);
+  }
+
+  // Returns the time spent waiting for jobs since the last call in tsc_clock ticks, summed over the waiting threads. Convert with
+  // tsc_clock::to_duration, which calibrates the clock on first use.
+  std::uint64_t take_wait_ticks()
+  {
+    return wait_ticks_.exchange(0, std::memory_order_relaxed);
+  }
+
+  void             set_thread_pool(di::thread_pool* thread_pool)
+  {
+    thread_pool_ = thread_pool;
+  }
+  di::thread_pool* thread_pool    () const
+  {
+    return thread_pool_;
+  }
+  // Number of threads which may run jobs at once: the workers plus the waiting thread.
+  std::size_t      concurrency    () const
+  {
+    return thread_pool_ ? thread_pool_->worker_count() + 1 : 1;
+  }
+
+private:
+  struct range_state
+  {
+    void run()
+    {
+      for (auto grain = next_grain.fetch_add(1, std::memory_order_relaxed); grain < grain_count; grain = next_grain.fetch_add(1, std::memory_order_relaxed))
+      {
+        try
+        {
+          for (auto i = begin + grain * grain_size, last = (std::min)(i + grain_size, end); i < last; ++i)
+            call(context, i);
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!exception)
+            exception = std::current_exception();
+        }
+      }
+    }
+
+    const void*              context    ;
+    void                   (*call)(const void*, std::size_t);
+    std::size_t              begin      ;
+    std::size_t              end        ;
+    std::size_t              grain_size ;
+    std::size_t              grain_count;
+    std::atomic<std::size_t> next_grain {0};
+    std::atomic<std::size_t> helpers    {0};
+    std::mutex               mutex      ;
+    std::exception_ptr       exception  ;
+  };
+
+  di::thread_pool*           thread_pool_;
+  std::atomic<std::uint64_t> wait_ticks_ {0};
+};
+
+// Task group runs jobs on a job system and joins them, at the latest on destruction, so that the jobs of a tick end with it:
+//
+//   di::task_group group(engine_->jobs());
+//   group.run ([&] { simulate(particles); });
+//   group.run ([&] { simulate(cloth    ); });
+//   group.then([&] { collide (particles, cloth); }); // After both simulations.
+//   group.wait();
+class task_group final
+{
+public:
+  explicit task_group  (job_system& job_system) : job_system_(job_system)
+  {
+    stages_.emplace_back();
+  }
+  task_group           (const task_group&  that) = delete ;
+  task_group           (      task_group&& temp) = delete ;
+ ~task_group           ()
+  {
+    join();
+  }
+  task_group& operator=(const task_group&  that) = delete ;
+  task_group& operator=(      task_group&& temp) = delete ;
+
+  // Runs the function as a job. Jobs of a group are unordered among each other.
+  template<typename function_type>
+  void run (function_type&& function)
+  {
+    const auto thread_pool = job_system_.thread_pool();
+    if (!thread_pool)
+    {
+      invoke(function);
+      return;
+    }
+
+    auto& stage = stages_.back();
+    stage  .pending.fetch_add(1, std::memory_order_relaxed);
+    pending_       .fetch_add(1, std::memory_order_relaxed);
+    thread_pool->submit([this, &stage, function = std::forward<function_type>(function)] () mutable
+    {
+      invoke(function);
+      release(stage);
+      pending_.fetch_sub(1, std::memory_order_release);
+    });
+  }
+  // Runs the continuation as a job once all the jobs and continuations run so far have completed. Jobs run after it are not ordered
+  // against it.
+  template<typename function_type>
+  void then(function_type&& function)
+  {
+    if (!job_system_.thread_pool())
+    {
+      invoke(function);
+      return;
+    }
+
+    auto& stage = stages_.back();
+    auto& next  = stages_.emplace_back(2);
+    stage.continuation = [this, &next, function = std::forward<function_type>(function)] () mutable
+    {
+      invoke(function);
+      release(next);
+      pending_.fetch_sub(1, std::memory_order_release);
+    };
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    release(stage); // The hold of the group, so that the continuation cannot start before it is set.
+  }
+  // Blocks (running pending jobs) until all jobs and continuations have completed. Rethrows the first exception thrown by them.
+  void wait()
+  {
+    join();
+    if (exception_)
+      std::rethrow_exception(std::exchange(exception_, nullptr));
+  }
+
+private:
+  // The jobs run between two continuations. Pending counts them, a hold by the group released when the next continuation is set and, after
+  // the first stage, a hold released by the continuation of the previous stage.
+  struct stage
+  {
+    explicit stage(const std::size_t holds = 1) : pending(holds)
+    {
+
+    }
+
+    std::atomic<std::size_t> pending     ;
+    std::function<void()>    continuation;
+  };
+
+  template<typename function_type>
+  void invoke (function_type& function)
+  {
+    try
+    {
+      function();
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!exception_)
+        exception_ = std::current_exception();
+    }
+  }
+  void release(stage& stage)
+  {
+    if (stage.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      job_system_.thread_pool()->submit(std::move(stage.continuation));
+  }
+  void join   ()
+  {
+    job_system_.wait([this] { return pending_.load(std::memory_order_acquire) == 0; });
+  }
+
+  job_system&              job_system_;
+  std::deque<stage>        stages_    ; // A deque keeps the stages in place while jobs refer to them.
+  std::atomic<std::size_t> pending_   {0};
+  std::mutex               mutex_     ;
+  std::exception_ptr       exception_ ;
+};
+}
+
+#endif
@@ -0,0 +1,521 @@
+#ifndef DI_UTILITY_SIGNAL_HPP_
+#define DI_UTILITY_SIGNAL_HPP_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace di
+{
+// Unsynchronized signals are connected to, disconnected from and emitted on one thread at a time. Synchronized signals may be used from any
+// thread; emission is lock-free, connecting and disconnecting take a mutex.
+struct unsynchronized_signal_policy { };
+struct synchronized_signal_policy   { };
+
+// The policy of signals which do not name one, including those of the engine's systems. Define DI_SIGNAL_POLICY before including to change
+// it for all of them. As systems connect to each other's signals in initialize(), the engine then runs all initialize() hooks on the main
+// thread when the policy is unsynchronized.
+#ifndef DI_SIGNAL_POLICY
+#define DI_SIGNAL_POLICY di::synchronized_signal_policy
+#endif
+using default_signal_policy = DI_SIGNAL_POLICY;
+
+// A slot's callable. Callables of up to inline_capacity bytes are stored inline, larger ones on the heap.
+template<typename... argument_types>
+class signal_slot final
+{
+public:
+  static constexpr std::size_t inline_capacity = 4 * sizeof(void*);
+
+  signal_slot           () = default;
+  template<typename function_type, typename = std::enable_if_t<!std::is_same<std::decay_t<function_type>, signal_slot>::value>>
+  explicit signal_slot  (function_type&& function)
+  {
+    using callable_type = std::decay_t<function_type>;
+    if constexpr (is_inline<callable_type>())
+    {
+      new (storage_) callable_type(std::forward<function_type>(function));
+      invoke_ = [ ] (void* storage, argument_types&... arguments) { (*std::launder(static_cast<callable_type*>(storage)))(arguments...); };
+      manage_ = [ ] (void* source, void* target)
+      {
+        const auto callable = std::launder(static_cast<callable_type*>(source));
+        if (target) new (target) callable_type(std::move(*callable));
+        callable->~callable_type();
+      };
+    }
+    else
+    {
+      new (storage_) callable_type*(new callable_type(std::forward<function_type>(function)));
+      invoke_ = [ ] (void* storage, argument_types&... arguments) { (**static_cast<callable_type**>(storage))(arguments...); };
+      manage_ = [ ] (void* source, void* target)
+      {
+        const auto callable = static_cast<callable_type**>(source);
+        if (target) new (target) callable_type*(*callable);
+        else        delete *callable;
+      };
+    }
+  }
+  signal_slot           (const signal_slot&  that) = delete;
+  signal_slot           (      signal_slot&& temp) noexcept
+  {
+    *this = std::move(temp);
+  }
+ ~signal_slot           ()
+  {
+    reset();
+  }
+  signal_slot& operator=(const signal_slot&  that) = delete;
+  signal_slot& operator=(      signal_slot&& temp) noexcept
+  {
+    if (this != &temp)
+    {
+      reset();
+      if (temp.manage_)
+        temp.manage_(temp.storage_, storage_);
+      invoke_      = temp.invoke_;
+      manage_      = temp.manage_;
+      temp.invoke_ = nullptr;
+      temp.manage_ = nullptr;
+    }
+    return *this;
+  }
+
+  void operator()(argument_types&... arguments) const
+  {
+    invoke_(const_cast<unsigned char*>(storage_), arguments...);
+  }
+  explicit operator bool() const
+  {
+    return invoke_ != nullptr;
+  }
+
+  void reset()
+  {
+    if (manage_)
+      manage_(storage_, nullptr);
+    invoke_ = nullptr;
+    manage_ = nullptr;
+  }
+
+private:
+  template<typename callable_type>
+  static constexpr bool is_inline()
+  {
+    return sizeof(callable_type) <= inline_capacity && alignof(callable_type) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<callable_type>::value;
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[inline_capacity];
+  void (*invoke_)(void*, argument_types&...) = nullptr;
+  void (*manage_)(void*, void*)              = nullptr; // Moves to the target and destroys the source, or destroys if the target is null.
+};
+
+// The slots of a signal, shared with its connections.
+class signal_core_base
+{
+public:
+  virtual ~signal_core_base() = default;
+
+  virtual void disconnect(std::uint64_t id)       = 0;
+  virtual bool connected (std::uint64_t id) const = 0;
+};
+
+template<typename policy, typename... argument_types>
+class signal_core;
+
+// Slots are stored in connection order, the first inline_slot_count inline. Slots connected during an emission are added after it, slots
+// disconnected during an emission are destroyed after it.
+template<typename... argument_types>
+class signal_core<unsynchronized_signal_policy, argument_types...> final : public signal_core_base
+{
+public:
+  static constexpr std::size_t inline_slot_count = 4;
+
+  std::uint64_t connect   (signal_slot<argument_types...>&& function)
+  {
+    const auto id = next_id_++;
+    if (emitting_ > 0)
+      pending_.push_back({id, std::move(function)});
+    else
+      push_back({id, std::move(function)});
+    return id;
+  }
+  void          disconnect(const std::uint64_t id) override
+  {
+    const auto count = size();
+    for (std::size_t i = 0; i < count; ++i)
+      if (at(i).id == id)
+      {
+        at(i).id = 0;
+        dirty_   = true;
+        break;
+      }
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(), [id] (const entry& entry) { return entry.id == id; }), pending_.end());
+    if (emitting_ == 0)
+      compact();
+  }
+  bool          connected (const std::uint64_t id) const override
+  {
+    const auto count = size();
+    for (std::size_t i = 0; i < count; ++i)
+      if (at(i).id == id)
+        return true;
+    return std::any_of(pending_.begin(), pending_.end(), [id] (const entry& entry) { return entry.id == id; });
+  }
+  void          disconnect_all()
+  {
+    const auto count = size();
+    for (std::size_t i = 0; i < count; ++i)
+      at(i).id = 0;
+    pending_.clear();
+    dirty_ = count > 0;
+    if (emitting_ == 0)
+      compact();
+  }
+  std::size_t   slot_count() const
+  {
+    const auto count = size();
+    std::size_t connected_count = pending_.size();
+    for (std::size_t i = 0; i < count; ++i)
+      if (at(i).id != 0)
+        ++connected_count;
+    return connected_count;
+  }
+
+  void emit(argument_types&... arguments)
+  {
+    const auto count = inline_size_;
+    if (count == 0 && overflow_.empty()) return;
+
+    ++emitting_;
+    for (std::size_t i = 0; i < count; ++i)
+      if (inline_[i].id != 0)
+        inline_[i].function(arguments...);
+    const auto overflow_count = overflow_.size();
+    for (std::size_t i = 0; i < overflow_count; ++i)
+      if (overflow_[i].id != 0)
+        overflow_[i].function(arguments...);
+    if (--emitting_ == 0 && (dirty_ || !pending_.empty()))
+    {
+      compact();
+      for (auto& entry : pending_)
+        push_back(std::move(entry));
+      pending_.clear();
+    }
+  }
+
+private:
+  struct entry
+  {
+    std::uint64_t                  id       = 0; // Zero once disconnected.
+    signal_slot<argument_types...> function ;
+  };
+
+  std::size_t  size     () const
+  {
+    return inline_size_ + overflow_.size();
+  }
+  entry&       at       (const std::size_t index)
+  {
+    return index < inline_slot_count ? inline_[index] : overflow_[index - inline_slot_count];
+  }
+  const entry& at       (const std::size_t index) const
+  {
+    return index < inline_slot_count ? inline_[index] : overflow_[index - inline_slot_count];
+  }
+  void         push_back(entry&& entry)
+  {
+    if (inline_size_ < inline_slot_count)
+      inline_[inline_size_++] = std::move(entry);
+    else
+      overflow_.push_back(std::move(entry));
+  }
+  void         compact  ()
+  {
+    if (!dirty_) return;
+    dirty_ = false;
+
+    const auto  count = size();
+    std::size_t kept  = 0;
+    for (std::size_t i = 0; i < count; ++i)
+      if (at(i).id != 0)
+      {
+        if (kept != i)
+          at(kept) = std::move(at(i));
+        ++kept;
+      }
+    for (auto i = kept; i < (std::min)(count, inline_slot_count); ++i)
+      inline_[i] = entry();
+    inline_size_ = (std::min)(kept, inline_slot_count);
+    overflow_.resize(kept > inline_slot_count ? kept - inline_slot_count : 0);
+  }
+
+  std::array<entry, inline_slot_count> inline_      ;
+  std::size_t                          inline_size_ = 0;
+  std::vector<entry>                   overflow_    ; // Used once the inline slots are full.
+  std::vector<entry>                   pending_     ; // Connected during an emission.
+  std::uint64_t                        next_id_     = 1;
+  std::size_t                          emitting_    = 0;
+  bool                                 dirty_       = false;
+};
+
+// Emission walks an immutable snapshot of the slots without locking. Connecting and disconnecting publish a new snapshot under the mutex;
+// replaced snapshots and disconnected slots are retired until no emission is in progress. A slot may still be called by an emission on
+// another thread which began before it was disconnected.
+template<typename... argument_types>
+class signal_core<synchronized_signal_policy, argument_types...> final : public signal_core_base
+{
+public:
+  ~signal_core()
+  {
+    delete snapshot_.load(std::memory_order_relaxed);
+  }
+
+  std::uint64_t connect   (signal_slot<argument_types...>&& function)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto id = next_id_++;
+    nodes_.push_back(std::make_unique<node>(id, std::move(function)));
+
+    auto next = std::make_unique<snapshot>();
+    next->reserve(nodes_.size());
+    for (auto& node : nodes_)
+      next->push_back(node.get());
+    publish(lock, std::move(next), nullptr);
+    return id;
+  }
+  void          disconnect(const std::uint64_t id) override
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto iterator = std::find_if(nodes_.begin(), nodes_.end(), [id] (const std::unique_ptr<node>& node) { return node->id == id; });
+    if (iterator == nodes_.end()) return;
+
+    auto removed = std::move(*iterator);
+    nodes_.erase(iterator);
+    removed->connected.store(false, std::memory_order_release);
+
+    std::unique_ptr<snapshot> next;
+    if (!nodes_.empty())
+    {
+      next = std::make_unique<snapshot>();
+      next->reserve(nodes_.size());
+      for (auto& node : nodes_)
+        next->push_back(node.get());
+    }
+    publish(lock, std::move(next), std::move(removed));
+  }
+  bool          connected (const std::uint64_t id) const override
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::any_of(nodes_.begin(), nodes_.end(), [id] (const std::unique_ptr<node>& node) { return node->id == id; });
+  }
+  void          disconnect_all()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto& node : nodes_)
+    {
+      node->connected.store(false, std::memory_order_release);
+      retired_nodes_.push_back(std::move(node));
+    }
+    nodes_.clear();
+    publish(lock, nullptr, nullptr);
+  }
+  std::size_t   slot_count() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nodes_.size();
+  }
+
+  void emit(argument_types&... arguments)
+  {
+    if (!snapshot_.load(std::memory_order_relaxed)) return;
+
+    emitting_.fetch_add(1, std::memory_order_seq_cst);
+    if (const auto current = snapshot_.load(std::memory_order_seq_cst))
+      for (const auto node : *current)
+        if (node->connected.load(std::memory_order_acquire))
+          node->function(arguments...);
+    if (emitting_.fetch_sub(1, std::memory_order_seq_cst) == 1 && retiring_.load(std::memory_order_relaxed))
+    {
+      std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+      if (lock) collect(lock);
+    }
+  }
+
+private:
+  struct node
+  {
+    node(const std::uint64_t id, signal_slot<argument_types...>&& function) : id(id), function(std::move(function))
+    {
+
+    }
+
+    std::uint64_t                  id        ;
+    signal_slot<argument_types...> function  ;
+    std::atomic<bool>              connected {true};
+  };
+  using snapshot = std::vector<node*>;
+
+  // The snapshot is published before the emission count is read, and emissions count themselves before reading the snapshot, so that an
+  // emission which may still read a retired snapshot or slot holds off its collection.
+  void publish(std::unique_lock<std::mutex>& lock, std::unique_ptr<snapshot> next, std::unique_ptr<node> removed)
+  {
+    retired_snapshots_.emplace_back(snapshot_.exchange(next.release(), std::memory_order_seq_cst));
+    if (removed)
+      retired_nodes_.push_back(std::move(removed));
+    retiring_.store(true, std::memory_order_relaxed);
+    collect(lock);
+  }
+  // Destroys the retired snapshots and slots outside the lock, as destroying a slot may disconnect others.
+  void collect(std::unique_lock<std::mutex>& lock)
+  {
+    if (emitting_.load(std::memory_order_seq_cst) != 0) return;
+    auto snapshots = std::move(retired_snapshots_);
+    auto nodes     = std::move(retired_nodes_);
+    retired_snapshots_.clear();
+    retired_nodes_    .clear();
+    retiring_.store(false, std::memory_order_relaxed);
+    lock.unlock();
+  }
+
+  mutable std::mutex                     mutex_            ;
+  std::atomic<snapshot*>                 snapshot_         {nullptr}; // Null when there are no slots.
+  std::atomic<std::size_t>               emitting_         {0};
+  std::atomic<bool>                      retiring_         {false};
+  std::vector<std::unique_ptr<node>>     nodes_            ; // In connection order.
+  std::vector<std::unique_ptr<snapshot>> retired_snapshots_;
+  std::vector<std::unique_ptr<node>>     retired_nodes_    ;
+  std::uint64_t                          next_id_          = 1;
+};
+
+// Refers to a slot of a signal. Disconnecting after the signal has been destroyed does nothing.
+class connection
+{
+public:
+  connection           () = default;
+  connection           (std::weak_ptr<signal_core_base> core, const std::uint64_t id) : core_(std::move(core)), id_(id)
+  {
+
+  }
+  connection           (const connection&  that) = default;
+  connection           (      connection&& temp) = default;
+  ~connection          ()                        = default;
+  connection& operator=(const connection&  that) = default;
+  connection& operator=(      connection&& temp) = default;
+
+  void disconnect()
+  {
+    if (const auto core = core_.lock())
+      core->disconnect(id_);
+    core_.reset();
+  }
+  bool connected () const
+  {
+    const auto core = core_.lock();
+    return core && core->connected(id_);
+  }
+
+private:
+  std::weak_ptr<signal_core_base> core_;
+  std::uint64_t                   id_   = 0;
+};
+
+// Disconnects on destruction.
+class scoped_connection : public connection
+{
+public:
+  scoped_connection           () = default;
+  scoped_connection           (const connection& that) : connection(that)
+  {
+
+  }
+  scoped_connection           (const scoped_connection&  that) = delete ;
+  scoped_connection           (      scoped_connection&& temp) = default;
+ ~scoped_connection           ()
+  {
+    disconnect();
+  }
+  scoped_connection& operator=(const scoped_connection&  that) = delete ;
+  scoped_connection& operator=(      scoped_connection&& temp)
+  {
+    if (this != &temp)
+    {
+      disconnect();
+      connection::operator=(std::move(temp));
+    }
+    return *this;
+  }
+  scoped_connection& operator=(const connection& that)
+  {
+    disconnect();
+    connection::operator=(that);
+    return *this;
+  }
+
+  connection release()
+  {
+    connection released(std::move(*this));
+    connection::operator=(connection());
+    return released;
+  }
+};
+
+// A replacement for boost::signals2::signal on hot paths: emitting does not lock, copy the slots or touch reference counts, and a signal
+// without slots costs one load. Slots are called in connection order; their results are discarded.
+template<typename signature, typename policy = default_signal_policy>
+class signal;
+
+template<typename result_type, typename... argument_types, typename policy>
+class signal<result_type(argument_types...), policy> final
+{
+public:
+  using core_type = signal_core<policy, argument_types...>;
+
+  signal           () : core_(std::make_shared<core_type>())
+  {
+
+  }
+  signal           (const signal&  that) = delete ;
+  signal           (      signal&& temp) = default;
+ ~signal           ()                    = default;
+  signal& operator=(const signal&  that) = delete ;
+  signal& operator=(      signal&& temp) = default;
+
+  template<typename function_type>
+  connection  connect              (function_type&& function)
+  {
+    if (!core_) core_ = std::make_shared<core_type>();
+    return connection(core_, core_->connect(signal_slot<argument_types...>(std::forward<function_type>(function))));
+  }
+  void        disconnect_all_slots ()
+  {
+    if (core_) core_->disconnect_all();
+  }
+  std::size_t num_slots            () const
+  {
+    return core_ ? core_->slot_count() : 0;
+  }
+  bool        empty                () const
+  {
+    return num_slots() == 0;
+  }
+
+  void        operator()           (argument_types... arguments) const
+  {
+    if (core_)
+      core_->emit(arguments...);
+  }
+
+private:
+  std::shared_ptr<core_type> core_;
+};
+}
+
+#endif
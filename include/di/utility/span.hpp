@@ -0,0 +1,66 @@
+#ifndef DI_UTILITY_SPAN_HPP_
+#define DI_UTILITY_SPAN_HPP_
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace di
+{
+// A view of a contiguous sequence, for handing out batches without copying them. A minimal stand-in for C++20's std::span.
+template<typename type>
+class span
+{
+public:
+  using element_type = type;
+  using value_type   = std::remove_cv_t<type>;
+  using iterator     = type*;
+
+  constexpr span  ()                                            = default;
+  constexpr span  (type* data, const std::size_t size) : data_(data), size_(size)
+  {
+
+  }
+  template<typename container_type, typename = std::enable_if_t<std::is_convertible<decltype(std::declval<container_type&>().data()), type*>::value>>
+  constexpr span  (container_type& container) : data_(container.data()), size_(container.size())
+  {
+
+  }
+  template<typename other_type, typename = std::enable_if_t<std::is_convertible<other_type*, type*>::value>>
+  constexpr span  (const span<other_type>& that) : data_(that.data()), size_(that.size())
+  {
+
+  }
+
+  constexpr type*       data      () const
+  {
+    return data_;
+  }
+  constexpr std::size_t size      () const
+  {
+    return size_;
+  }
+  constexpr bool        empty     () const
+  {
+    return size_ == 0;
+  }
+  constexpr iterator    begin     () const
+  {
+    return data_;
+  }
+  constexpr iterator    end       () const
+  {
+    return data_ + size_;
+  }
+  constexpr type&       operator[](const std::size_t index) const
+  {
+    return data_[index];
+  }
+
+private:
+  type*       data_ = nullptr;
+  std::size_t size_ = 0;
+};
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef DI_UTILITY_TASK_GRAPH_HPP_
+#define DI_UTILITY_TASK_GRAPH_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <di/utility/thread_pool.hpp>
+
+namespace di
+{
+// Task graph is a directed acyclic graph of tasks. Execution runs every task once its predecessors have completed,
+// dispatching free tasks to a thread pool and main-thread tasks to the calling thread.
+class task_graph final
+{
+public:
+  using task = std::function<void()>;
+
+  task_graph           ()                        = default;
+  task_graph           (const task_graph&  that) = delete ;
+  task_graph           (      task_graph&& temp) = delete ;
+ ~task_graph           ()                        = default;
+  task_graph& operator=(const task_graph&  that) = delete ;
+  task_graph& operator=(      task_graph&& temp) = delete ;
+
+  std::size_t add_node     (task task, const bool main_thread = false)
+  {
+    nodes_.emplace_back(std::make_unique<node>());
+    nodes_.back()->function    = std::move(task);
+    nodes_.back()->main_thread = main_thread;
+    return nodes_.size() - 1;
+  }
+  void        add_edge     (const std::size_t source, const std::size_t target)
+  {
+    nodes_[source]->successors.push_back(target);
+    nodes_[target]->predecessor_count++;
+  }
+  void        clear        ()
+  {
+    nodes_.clear();
+  }
+
+  std::size_t size         () const
+  {
+    return nodes_.size();
+  }
+  bool        empty        () const
+  {
+    return nodes_.empty();
+  }
+
+  // Returns the nodes in a topological order (Kahn's algorithm, ties broken by insertion order). Throws if the graph contains a cycle.
+  std::vector<std::size_t> topological_order() const
+  {
+    std::vector<std::size_t> order     ;
+    std::vector<std::size_t> in_degrees(nodes_.size());
+    std::deque <std::size_t> ready     ;
+    for (std::size_t i = 0; i < nodes_.size(); ++i)
+      if ((in_degrees[i] = nodes_[i]->predecessor_count) == 0)
+        ready.push_back(i);
+    while (!ready.empty())
+    {
+      const auto index = ready.front();
+      ready.pop_front();
+      order.push_back(index);
+      for (auto successor : nodes_[index]->successors)
+        if (--in_degrees[successor] == 0)
+          ready.push_back(successor);
+    }
+    if (order.size() != nodes_.size())
+      throw std::runtime_error("Task graph contains a cycle.");
+    return order;
+  }
+
+  // Runs the graph serially on the calling thread.
+  void execute(const std::vector<std::size_t>& order)
+  {
+    for (auto index : order)
+      nodes_[index]->function();
+  }
+  // Runs the graph on the thread pool. Main-thread tasks are run by the calling thread, which blocks until the whole graph completes.
+  void execute(thread_pool& thread_pool)
+  {
+    if (nodes_.empty()) return;
+
+    remaining_   = nodes_.size();
+    completed_   = false;
+    exception_   = nullptr;
+    thread_pool_ = &thread_pool;
+    for (auto& node : nodes_)
+      node->pending.store(node->predecessor_count, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < nodes_.size(); ++i)
+      if (nodes_[i]->predecessor_count == 0)
+        schedule(thread_pool, i);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+      condition_variable_.wait(lock, [&] { return !main_thread_tasks_.empty() || completed_; });
+      if (main_thread_tasks_.empty())
+        break;
+
+      const auto index = main_thread_tasks_.front();
+      main_thread_tasks_.pop_front();
+      lock.unlock();
+      run(thread_pool, index);
+      lock.lock  ();
+    }
+    lock.unlock();
+
+    if (exception_)
+      std::rethrow_exception(exception_);
+  }
+
+protected:
+  struct node
+  {
+    task                     function         ;
+    bool                     main_thread      = false;
+    std::vector<std::size_t> successors       ;
+    std::size_t              predecessor_count = 0;
+    std::atomic<std::size_t> pending          {0};
+  };
+
+  void schedule(thread_pool& thread_pool, const std::size_t index)
+  {
+    if (nodes_[index]->main_thread)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      main_thread_tasks_.push_back(index);
+      condition_variable_.notify_all();
+    }
+    else
+      thread_pool.submit([this, index] { run(*thread_pool_, index); }); // Small enough for std::function to store without allocating.
+  }
+  void run     (thread_pool& thread_pool, const std::size_t index)
+  {
+    try
+    {
+      nodes_[index]->function();
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!exception_)
+        exception_ = std::current_exception();
+    }
+
+    for (auto successor : nodes_[index]->successors)
+      if (nodes_[successor]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        schedule(thread_pool, successor);
+
+    // Only the last node wakes the waiting thread. It notifies under the lock: once completed_ is set the waiting thread may rebuild or
+    // destroy the graph.
+    if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      completed_ = true;
+      condition_variable_.notify_all();
+    }
+  }
+
+  std::vector<std::unique_ptr<node>> nodes_             ;
+  std::deque<std::size_t>            main_thread_tasks_ ;
+  std::atomic<std::size_t>           remaining_         {0};
+  bool                               completed_         = false;
+  std::exception_ptr                 exception_         ;
+  thread_pool*                       thread_pool_       = nullptr;
+  std::mutex                         mutex_             ;
+  std::condition_variable            condition_variable_;
+};
+}
+
+#endif
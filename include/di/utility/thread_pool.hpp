@@ -0,0 +1,238 @@
+#ifndef DI_UTILITY_THREAD_POOL_HPP_
+#define DI_UTILITY_THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+// Keeps windows.h from defining the min and max macros and pulling in the rarely used APIs for the including translation unit. The library
+// itself calls (std::min) and (std::max) parenthesized, so that it also compiles after a windows.h included without NOMINMAX.
+#ifndef NOMINMAX
+#define NOMINMAX
+#define DI_UNDEF_NOMINMAX_
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define DI_UNDEF_WIN32_LEAN_AND_MEAN_
+#endif
+#include <windows.h>
+#ifdef DI_UNDEF_NOMINMAX_
+#undef NOMINMAX
+#undef DI_UNDEF_NOMINMAX_
+#endif
+#ifdef DI_UNDEF_WIN32_LEAN_AND_MEAN_
+#undef WIN32_LEAN_AND_MEAN
+#undef DI_UNDEF_WIN32_LEAN_AND_MEAN_
+#endif
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace di
+{
+// Thread pool keeps a fixed set of workers, each owning a task deque. A worker pops from the back of its own deque and steals from the front of the others when it runs dry.
+class thread_pool final
+{
+public:
+  using task = std::function<void()>;
+
+  // Pinned workers are bound to cores 1, 2, ... (wrapping around), leaving core 0 to the thread which submits the frame's work.
+  explicit thread_pool  (const std::size_t worker_count = std::thread::hardware_concurrency(), const bool pin_workers = false)
+  {
+    queues_ .reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i)
+      queues_.emplace_back(std::make_unique<queue>());
+    workers_.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i)
+    {
+      workers_.emplace_back(&thread_pool::work, this, i);
+      if (pin_workers)
+        pin(workers_.back(), (i + 1) % (std::max)(std::thread::hardware_concurrency(), 1u));
+    }
+  }
+  thread_pool           (const thread_pool&  that) = delete ;
+  thread_pool           (      thread_pool&& temp) = delete ;
+ ~thread_pool           ()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_running_ = false;
+    }
+    condition_variable_.notify_all();
+    for (auto& worker : workers_)
+      worker.join();
+  }
+  thread_pool& operator=(const thread_pool&  that) = delete ;
+  thread_pool& operator=(      thread_pool&& temp) = delete ;
+
+  void        submit      (task task)
+  {
+    // Tasks submitted from a worker go to its own deque (cache-hot, LIFO), the rest are distributed round robin.
+    const auto index = current_pool() == this ? current_index() : next_queue_++ % queues_.size();
+    {
+      std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+      queues_[index]->push_back(std::move(task));
+      pending_.fetch_add(1);
+    }
+    // Pairs with the sleeping worker counting itself before reading pending_: either it sees the task or this sees it. Taking the mutex
+    // makes sure it is either still to read pending_ or already waiting.
+    if (sleeping_.load() > 0)
+    {
+      { std::lock_guard<std::mutex> lock(mutex_); }
+      condition_variable_.notify_one();
+    }
+  }
+
+  // Runs a pending task on the calling thread, if there is one. Lets a thread which waits for tasks help instead of blocking.
+  bool        run_one     ()
+  {
+    task task;
+    if (queues_.empty() || !pop(current_pool() == this ? current_index() : 0, task))
+      return false;
+    task();
+    return true;
+  }
+
+  std::size_t worker_count() const
+  {
+    return workers_.size();
+  }
+  // Whether the calling thread is one of the workers of this pool.
+  bool        is_worker   () const
+  {
+    return current_pool() == this;
+  }
+
+protected:
+  // A ring buffer which grows by doubling and never shrinks, so that submitting tasks in a steady state does not allocate.
+  struct queue
+  {
+    bool empty    () const
+    {
+      return size == 0;
+    }
+    void push_back(task&& task)
+    {
+      if (size == tasks.size())
+      {
+        std::vector<thread_pool::task> grown((std::max<std::size_t>)(tasks.size() * 2, 16));
+        for (std::size_t i = 0; i < size; ++i)
+          grown[i] = std::move(tasks[(head + i) % tasks.size()]);
+        tasks = std::move(grown);
+        head  = 0;
+      }
+      tasks[(head + size++) % tasks.size()] = std::move(task);
+    }
+    task pop_back ()
+    {
+      return std::move(tasks[(head + --size) % tasks.size()]);
+    }
+    task pop_front()
+    {
+      auto task = std::move(tasks[head]);
+      head = (head + 1) % tasks.size();
+      --size;
+      return task;
+    }
+
+    std::mutex        mutex;
+    std::vector<task> tasks;
+    std::size_t       head = 0;
+    std::size_t       size = 0;
+  };
+
+  static void pin(std::thread& thread, const std::size_t core)
+  {
+#if defined(_WIN32)
+    SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << core);
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET (core, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+  }
+
+  static thread_pool*& current_pool ()
+  {
+    thread_local thread_pool* pool = nullptr;
+    return pool;
+  }
+  static std::size_t&  current_index()
+  {
+    thread_local std::size_t index = 0;
+    return index;
+  }
+
+  // Counts the task off pending_ under the lock of its deque, so that pending_ never counts a task which has already been taken.
+  bool pop  (const std::size_t index, task& task)
+  {
+    auto& own = *queues_[index];
+    {
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.empty())
+      {
+        task = own.pop_back();
+        pending_.fetch_sub(1);
+        return true;
+      }
+    }
+    for (std::size_t offset = 1; offset < queues_.size(); ++offset)
+    {
+      auto& victim = *queues_[(index + offset) % queues_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.empty())
+      {
+        task = victim.pop_front();
+        pending_.fetch_sub(1);
+        return true;
+      }
+    }
+    return false;
+  }
+  void work (const std::size_t index)
+  {
+    current_pool () = this;
+    current_index() = index;
+
+    while (true)
+    {
+      task task;
+      if (pop(index, task))
+      {
+        task();
+        continue;
+      }
+
+      // Out of tasks: sleep until one is submitted. A task which another thread took between the wake-up and the pop is no longer
+      // counted, so the worker goes back to sleep instead of spinning.
+      std::unique_lock<std::mutex> lock(mutex_);
+      sleeping_.fetch_add(1);
+      condition_variable_.wait(lock, [&] { return pending_.load() > 0 || !is_running_; });
+      sleeping_.fetch_sub(1);
+      if (pending_.load() == 0 && !is_running_)
+        return;
+    }
+  }
+
+  std::vector<std::unique_ptr<queue>> queues_            ;
+  std::vector<std::thread>            workers_           ;
+  std::atomic<std::size_t>            next_queue_        {0};
+  std::mutex                          mutex_             ;
+  std::condition_variable             condition_variable_;
+  std::atomic<std::size_t>            pending_           {0}; // Tasks in the deques.
+  std::atomic<std::size_t>            sleeping_          {0}; // Workers waiting on the condition variable.
+  bool                                is_running_        = true; // Guarded by mutex_.
+};
+}
+
+#endif
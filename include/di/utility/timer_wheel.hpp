@@ -0,0 +1,396 @@
+#ifndef DI_UTILITY_TIMER_WHEEL_HPP_
+#define DI_UTILITY_TIMER_WHEEL_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace di
+{
+// Timer wheel runs delayed and periodic callbacks on a clock advanced in steps, e.g. by the frame delta once per frame. Timers live in a
+// hierarchy of four wheels of 64 slots (at the default 1 ms resolution, the first spans 64 ms and the last 4.6 hours; longer delays are
+// re-inserted), so that scheduling and cancelling take constant time and advancing visits at most one slot per 64 ticks passed. Callbacks
+// are stored inline in pooled timers, so that nothing is allocated per timer once the pool has grown. Scheduling and cancelling are
+// thread-safe. advance() runs the expired callbacks in order of expiry, on the calling thread and outside the lock, so that callbacks may
+// schedule and cancel timers.
+class timer_wheel final
+{
+public:
+  using duration = std::chrono::duration<double, std::milli>;
+
+  struct timer_id
+  {
+    std::uint32_t index      = (std::numeric_limits<std::uint32_t>::max)();
+    std::uint32_t generation = 0;
+  };
+
+  static constexpr std::size_t callback_capacity = 48; // Bytes, the largest callable a timer stores.
+
+  explicit timer_wheel  (const duration resolution = duration(1.0)) : resolution_(resolution)
+  {
+
+  }
+  timer_wheel           (const timer_wheel&  that) = delete ;
+  timer_wheel           (      timer_wheel&& temp) = delete ;
+ ~timer_wheel           ()
+  {
+    clear();
+  }
+  timer_wheel& operator=(const timer_wheel&  that) = delete ;
+  timer_wheel& operator=(      timer_wheel&& temp) = delete ;
+
+  // Calls the function once, at the first advance() reaching the delay from now (rounded up to the resolution, at least one tick).
+  template<typename function_type>
+  timer_id schedule         (const duration delay , function_type&& function)
+  {
+    return add(delay, duration::zero(), std::forward<function_type>(function));
+  }
+  // Calls the function every period (rounded to the resolution, at least one tick), first one period from now. Periods stay aligned to
+  // the first; periods passed entirely within one advance() are called once.
+  template<typename function_type>
+  timer_id schedule_periodic(const duration period, function_type&& function)
+  {
+    return add(period, period, std::forward<function_type>(function));
+  }
+  // Returns false if the timer has already expired (unless periodic) or been cancelled. A timer cancelled by its own or a concurrent
+  // callback is not called again.
+  bool     cancel           (const timer_id id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto timer = find(id);
+    if (!timer || timer->cancelled)
+      return false;
+    if (timer->list)
+    {
+      unlink (*timer);
+      release(*timer);
+    }
+    else
+      timer->cancelled = true; // Running, released when its callback returns.
+    return true;
+  }
+  bool     is_scheduled     (const timer_id id) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto timer = find(id);
+    return timer && !timer->cancelled;
+  }
+
+  // Advances the time of the wheel by the delta and runs the callbacks of the timers expired meanwhile. Not reentrant.
+  void advance(const duration delta)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      time_ += delta;
+      const auto target = static_cast<std::uint64_t>((std::max)(std::floor(time_ / resolution_), 0.0));
+      while (current_ < target)
+      {
+        if (std::all_of(occupied_.begin(), occupied_.end(), [ ] (const std::uint64_t mask) { return mask == 0; }))
+        {
+          current_ = target;
+          break;
+        }
+
+        // Jump to the next occupied slot of the first wheel, but not past its end, where the slots of the outer wheels cascade.
+        const auto digit = current_ & slot_mask;
+        const auto later = digit == slot_mask ? std::uint64_t(0) : occupied_[0] & (~std::uint64_t(0) << (digit + 1));
+        current_ = (std::min)(target, current_ - digit + (later ? count_trailing_zeros(later) : slot_count));
+        for (auto level = level_count - 1; level > 0; --level)
+          if ((current_ & ((std::uint64_t(1) << (slot_bits * level)) - 1)) == 0)
+            cascade(level);
+
+        auto& slot = slots_[current_ & slot_mask];
+        while (slot.head)
+        {
+          const auto timer = slot.head;
+          unlink   (*timer);
+          push_back(expired_, *timer);
+        }
+      }
+    }
+    dispatch();
+  }
+
+  // A lower bound of the time until the next timer expires (exact within the first wheel's span), or duration::max() if none is scheduled.
+  duration next_expiry() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (expired_.head)
+      return duration::zero();
+
+    auto next = (std::numeric_limits<std::uint64_t>::max)();
+    for (std::size_t level = 0; level < level_count; ++level)
+    {
+      const auto mask = occupied_[level];
+      if (mask == 0) continue;
+
+      // Rotate so that bit 0 is the slot after the current one; the current slot itself comes around last.
+      const auto shift   = slot_bits * level;
+      const auto digit   = (current_ >> shift) & slot_mask;
+      const auto rotated = (mask >> ((digit + 1) & slot_mask)) | (mask << ((slot_mask - digit) & slot_mask));
+      const auto slot    = (digit + 1 + count_trailing_zeros(rotated)) & slot_mask;
+      const auto span    = std::uint64_t(1) << (shift + slot_bits);
+      auto       tick    = (current_ & ~(span - 1)) + (slot << shift);
+      if (tick <= current_)
+        tick += span;
+      next = (std::min)(next, tick);
+    }
+    return next == (std::numeric_limits<std::uint64_t>::max)() ? (duration::max)() : (std::max)(resolution_ * static_cast<double>(next) - time_, duration::zero());
+  }
+
+  // Cancels all timers but the running ones.
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& list : slots_)
+      while (list.head)
+      {
+        const auto timer = list.head;
+        unlink (*timer);
+        release(*timer);
+      }
+    while (expired_.head)
+    {
+      const auto timer = expired_.head;
+      unlink (*timer);
+      release(*timer);
+    }
+    occupied_.fill(0);
+  }
+
+  duration    resolution() const
+  {
+    return resolution_;
+  }
+  // The time advanced so far.
+  duration    time      () const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return time_;
+  }
+  // The number of scheduled (including running) timers.
+  std::size_t size      () const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+  }
+
+private:
+  static constexpr std::size_t   slot_bits   = 6;
+  static constexpr std::size_t   slot_count  = std::size_t(1) << slot_bits;
+  static constexpr std::uint64_t slot_mask   = slot_count - 1;
+  static constexpr std::size_t   level_count = 4;
+  static constexpr std::size_t   chunk_size  = 64; // Timers per pool allocation.
+
+  struct timer_list;
+  struct timer
+  {
+    alignas(std::max_align_t) unsigned char storage[callback_capacity];
+    void        (*invoke )(void*) = nullptr;
+    void        (*destroy)(void*) = nullptr;
+    std::uint64_t expiry          = 0; // Ticks.
+    std::uint64_t period          = 0; // Ticks, zero for a single call.
+    timer*        previous        = nullptr;
+    timer*        next            = nullptr; // Also links the free timers.
+    timer_list*   list            = nullptr; // Null while free or running.
+    std::uint32_t index           = 0;
+    std::uint32_t generation      = 0;
+    bool          cancelled       = false;
+  };
+  struct timer_list
+  {
+    timer* head = nullptr;
+    timer* tail = nullptr;
+  };
+
+  static std::size_t count_trailing_zeros(const std::uint64_t value)
+  {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<std::size_t>(index);
+#elif defined(__GNUC__)
+    return static_cast<std::size_t>(__builtin_ctzll(value));
+#else
+    std::size_t count = 0;
+    for (auto shifted = value; (shifted & 1) == 0; shifted >>= 1)
+      ++count;
+    return count;
+#endif
+  }
+
+  template<typename function_type>
+  timer_id add     (const duration delay, const duration period, function_type&& function)
+  {
+    using callable_type = std::decay_t<function_type>;
+    static_assert(sizeof (callable_type) <= callback_capacity     , "The callback exceeds the inline storage of a timer.");
+    static_assert(alignof(callable_type) <= alignof(std::max_align_t), "The callback is over-aligned.");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& timer = acquire();
+    new (timer.storage) callable_type(std::forward<function_type>(function));
+    timer.invoke  = [ ] (void* storage) { (*static_cast<callable_type*>(storage))(); };
+    timer.destroy = [ ] (void* storage) { static_cast<callable_type*>(storage)->~callable_type(); };
+    timer.period  = period > duration::zero() ? (std::max<std::uint64_t>)(static_cast<std::uint64_t>(std::llround(period / resolution_)), 1) : 0;
+    timer.expiry  = (std::max)(static_cast<std::uint64_t>((std::max)(std::ceil((time_ + delay) / resolution_), 0.0)), current_ + 1);
+    insert(timer);
+    return timer_id {timer.index, timer.generation};
+  }
+  timer*   find    (const timer_id id) const
+  {
+    if (id.index >= pool_size_) return nullptr;
+    const auto timer = &chunks_[id.index / chunk_size][id.index % chunk_size];
+    return timer->generation == id.generation && timer->invoke ? timer : nullptr;
+  }
+  timer&   acquire ()
+  {
+    if (!free_)
+    {
+      chunks_.push_back(std::make_unique<timer[]>(chunk_size));
+      for (auto i = chunk_size; i-- > 0;)
+      {
+        auto& timer = chunks_.back()[i];
+        timer.index = static_cast<std::uint32_t>(pool_size_ + i);
+        timer.next  = free_;
+        free_       = &timer;
+      }
+      pool_size_ += chunk_size;
+    }
+    const auto timer = free_;
+    free_ = timer->next;
+    ++size_;
+    return *timer;
+  }
+  void     release (timer& timer)
+  {
+    timer.destroy(timer.storage);
+    timer.invoke    = nullptr;
+    timer.destroy   = nullptr;
+    timer.cancelled = false;
+    ++timer.generation;
+    timer.next      = free_;
+    free_           = &timer;
+    --size_;
+  }
+
+  // Places the timer in the wheel whose span covers its delay, in the slot of its expiry; the outermost wheel takes any longer delay.
+  void     insert  (timer& timer)
+  {
+    if (timer.expiry <= current_)
+    {
+      push_back(expired_, timer);
+      return;
+    }
+    const auto delta  = timer.expiry - current_;
+    std::size_t level = 0;
+    while (level + 1 < level_count && delta >= std::uint64_t(1) << (slot_bits * (level + 1)))
+      ++level;
+    const auto expiry = (std::min)(timer.expiry, current_ + (std::uint64_t(1) << (slot_bits * level_count)) - 1);
+    const auto slot   = (expiry >> (slot_bits * level)) & slot_mask;
+    push_back(slots_[level * slot_count + slot], timer);
+    occupied_[level] |= std::uint64_t(1) << slot;
+  }
+  // Moves the timers of the current slot of an outer wheel, which expire within its span from now, into the inner wheels.
+  void     cascade (const std::size_t level)
+  {
+    const auto slot = (current_ >> (slot_bits * level)) & slot_mask;
+    auto&      list = slots_[level * slot_count + slot];
+    auto       head = list.head;
+    list = timer_list();
+    occupied_[level] &= ~(std::uint64_t(1) << slot);
+    while (head)
+    {
+      const auto next = head->next;
+      insert(*head);
+      head = next;
+    }
+  }
+  void     dispatch()
+  {
+    while (true)
+    {
+      timer* timer;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer = expired_.head;
+        if (!timer) return;
+        unlink(*timer);
+      }
+      try
+      {
+        timer->invoke(timer->storage);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finish(*timer);
+        throw;
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      finish(*timer);
+    }
+  }
+  void     finish  (timer& timer)
+  {
+    if (timer.period == 0 || timer.cancelled)
+    {
+      release(timer);
+      return;
+    }
+    if (timer.expiry <= current_)
+      timer.expiry += ((current_ - timer.expiry) / timer.period + 1) * timer.period;
+    insert(timer);
+  }
+
+  void     push_back(timer_list& list, timer& timer)
+  {
+    timer.list     = &list;
+    timer.previous = list.tail;
+    timer.next     = nullptr;
+    (list.tail ? list.tail->next : list.head) = &timer;
+    list.tail      = &timer;
+  }
+  void     unlink   (timer& timer)
+  {
+    auto& list = *timer.list;
+    (timer.previous ? timer.previous->next : list.head) = timer.next;
+    (timer.next     ? timer.next->previous : list.tail) = timer.previous;
+    if (!list.head && &list != &expired_)
+    {
+      const auto index = static_cast<std::size_t>(&list - slots_.data());
+      occupied_[index / slot_count] &= ~(std::uint64_t(1) << (index % slot_count));
+    }
+    timer.list     = nullptr;
+    timer.previous = nullptr;
+    timer.next     = nullptr;
+  }
+
+  duration                                         resolution_;
+  duration                                         time_      {0.0};
+  std::uint64_t                                    current_   = 0; // The last tick passed.
+  std::array<timer_list, slot_count * level_count> slots_     {};
+  std::array<std::uint64_t, level_count>           occupied_  {}; // A bit per non-empty slot, per wheel.
+  timer_list                                       expired_   ;
+  std::vector<std::unique_ptr<timer[]>>            chunks_    ;
+  std::size_t                                      pool_size_ = 0;
+  timer*                                           free_      = nullptr;
+  std::size_t                                      size_      = 0;
+  mutable std::mutex                               mutex_     ;
+};
+}
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef DI_UTILITY_TIMING_HISTOGRAM_HPP_
+#define DI_UTILITY_TIMING_HISTOGRAM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace di
+{
+struct timing_statistics
+{
+  std::size_t              count = 0;
+  std::chrono::nanoseconds p50   {0};
+  std::chrono::nanoseconds p95   {0};
+  std::chrono::nanoseconds p99   {0};
+  std::chrono::nanoseconds max   {0};
+};
+
+// Timing histogram is a lock-free log-linear histogram of durations (8 sub-buckets per power of two, i.e. at most 12.5% relative error).
+// It is rolling: samples go to one of two windows, and the older window is cleared whenever the current one holds window_size samples,
+// so that queries cover the last window_size to 2 * window_size samples. Recording is wait-free for a single writer; queries may run on any thread.
+class timing_histogram final
+{
+public:
+  static constexpr std::size_t sub_bucket_bits  = 3;
+  static constexpr std::size_t sub_bucket_count = std::size_t(1) << sub_bucket_bits;
+  static constexpr std::size_t bucket_count     = (40 - sub_bucket_bits + 2) * sub_bucket_count; // Up to 2^41 ns (~36 minutes).
+
+  explicit timing_histogram  (const std::size_t window_size = 1024) : window_size_((std::max<std::size_t>)(window_size, 1))
+  {
+    clear();
+  }
+  timing_histogram           (const timing_histogram&  that) = delete ;
+  timing_histogram           (      timing_histogram&& temp) = delete ;
+ ~timing_histogram           ()                              = default;
+  timing_histogram& operator=(const timing_histogram&  that) = delete ;
+  timing_histogram& operator=(      timing_histogram&& temp) = delete ;
+
+  void              record    (const std::chrono::nanoseconds duration)
+  {
+    auto  value   = static_cast<std::uint64_t>((std::max<std::int64_t>)(duration.count(), 0));
+    auto  current = current_.load(std::memory_order_relaxed);
+    auto& window  = windows_[current];
+
+    // Single writer: plain load-store pairs avoid locked instructions.
+    auto& bucket  = window.counts[bucket_index(value)];
+    bucket      .store(bucket      .load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (value > window.max.load(std::memory_order_relaxed))
+      window.max.store(value, std::memory_order_relaxed);
+    const auto size = window.size.load(std::memory_order_relaxed) + 1;
+    window.size .store(size, std::memory_order_release);
+
+    if (size >= window_size_)
+    {
+      auto& next = windows_[1 - current];
+      for (auto& count : next.counts)
+        count.store(0, std::memory_order_relaxed);
+      next.max .store(0, std::memory_order_relaxed);
+      next.size.store(0, std::memory_order_release);
+      current_ .store(1 - current, std::memory_order_release);
+    }
+  }
+  void              clear     ()
+  {
+    for (auto& window : windows_)
+    {
+      for (auto& count : window.counts)
+        count.store(0, std::memory_order_relaxed);
+      window.max .store(0, std::memory_order_relaxed);
+      window.size.store(0, std::memory_order_release);
+    }
+    current_.store(0, std::memory_order_release);
+  }
+  timing_statistics statistics() const
+  {
+    std::array<std::uint64_t, bucket_count> counts {};
+    std::uint64_t total = 0, max = 0;
+    for (auto& window : windows_)
+    {
+      for (std::size_t i = 0; i < bucket_count; ++i)
+      {
+        const auto count = window.counts[i].load(std::memory_order_relaxed);
+        counts[i] += count;
+        total     += count;
+      }
+      max = (std::max<std::uint64_t>)(max, window.max.load(std::memory_order_relaxed));
+    }
+
+    timing_statistics statistics;
+    statistics.count = static_cast<std::size_t>(total);
+    statistics.max   = std::chrono::nanoseconds(max);
+    statistics.p50   = (std::min)(percentile(counts, total, 0.50), statistics.max);
+    statistics.p95   = (std::min)(percentile(counts, total, 0.95), statistics.max);
+    statistics.p99   = (std::min)(percentile(counts, total, 0.99), statistics.max);
+    return statistics;
+  }
+
+  // The log-linear bucket of a value and the midpoint of a bucket, for histograms of other windowing schemes (e.g. frame_timer).
+  static std::size_t              bucket_index(const std::uint64_t value)
+  {
+    if (value < sub_bucket_count)
+      return static_cast<std::size_t>(value);
+    const auto exponent   = (std::min<std::size_t>)(floor_log2(value), 40);
+    const auto sub_bucket = static_cast<std::size_t>(value >> (exponent - sub_bucket_bits)) & (sub_bucket_count - 1);
+    return (std::min)((exponent - sub_bucket_bits + 1) * sub_bucket_count + sub_bucket, bucket_count - 1);
+  }
+  static std::size_t              floor_log2  (const std::uint64_t value)
+  {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<std::size_t>(index);
+#elif defined(__GNUC__)
+    return static_cast<std::size_t>(63 - __builtin_clzll(value));
+#else
+    std::size_t exponent = 0;
+    for (auto shifted = value; shifted >>= 1;)
+      ++exponent;
+    return exponent;
+#endif
+  }
+  static std::uint64_t            bucket_value(const std::size_t index)
+  {
+    // The midpoint of the bucket.
+    if (index < sub_bucket_count)
+      return index;
+    const auto exponent   = index / sub_bucket_count + sub_bucket_bits - 1;
+    const auto sub_bucket = index % sub_bucket_count;
+    const auto width      = std::uint64_t(1) << (exponent - sub_bucket_bits);
+    return ((sub_bucket_count + sub_bucket) << (exponent - sub_bucket_bits)) + width / 2;
+  }
+
+private:
+  struct window
+  {
+    std::array<std::atomic<std::uint32_t>, bucket_count> counts;
+    std::atomic<std::uint64_t>                           max   ;
+    std::atomic<std::size_t>                             size  ;
+  };
+
+  static std::chrono::nanoseconds percentile  (const std::array<std::uint64_t, bucket_count>& counts, const std::uint64_t total, const double fraction)
+  {
+    if (total == 0) return std::chrono::nanoseconds(0);
+    const auto    target     = (std::max<std::uint64_t>)(static_cast<std::uint64_t>(fraction * static_cast<double>(total) + 0.5), 1);
+    std::uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < bucket_count; ++i)
+      if ((cumulative += counts[i]) >= target)
+        return std::chrono::nanoseconds(bucket_value(i));
+    return std::chrono::nanoseconds(bucket_value(bucket_count - 1));
+  }
+
+  std::size_t              window_size_;
+  std::array<window, 2>    windows_    ;
+  std::atomic<std::size_t> current_    {0};
+};
+}
+
+#endif
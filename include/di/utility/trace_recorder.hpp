@@ -0,0 +1,238 @@
+#ifndef DI_UTILITY_TRACE_RECORDER_HPP_
+#define DI_UTILITY_TRACE_RECORDER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <di/utility/tsc_clock.hpp>
+
+namespace di
+{
+// Trace recorder collects timed spans into per-thread ring buffers (the oldest spans are overwritten) and writes them in the Chrome
+// trace event format, viewable in chrome://tracing or Perfetto. Names and categories are not copied and must outlive the recorder.
+// A thread's buffer is allocated on its first span while enabled and kept for its later spans. Recording is lock-free while a thread keeps
+// recording to the same recorder. Writing must not overlap with recording, e.g. call write() between frames.
+class trace_recorder final
+{
+public:
+  struct span
+  {
+    std::string_view name    ;
+    std::string_view category;
+    std::uint64_t    begin   ; // tsc_clock ticks.
+    std::uint64_t    end     ;
+  };
+
+  explicit trace_recorder  (const std::size_t capacity_per_thread = 65536) : id_(next_id()), capacity_(capacity_per_thread)
+  {
+
+  }
+  trace_recorder           (const trace_recorder&  that) = delete ;
+  trace_recorder           (      trace_recorder&& temp) = delete ;
+ ~trace_recorder           ()                            = default;
+  trace_recorder& operator=(const trace_recorder&  that) = delete ;
+  trace_recorder& operator=(      trace_recorder&& temp) = delete ;
+
+  bool               enabled          () const
+  {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  void               set_enabled      (const bool enabled)
+  {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+  // If set, the engine writes the trace to this file when run() returns.
+  const std::string& exit_filename    () const
+  {
+    return exit_filename_;
+  }
+  void               set_exit_filename(const std::string& filename)
+  {
+    exit_filename_ = filename;
+  }
+
+  void record         (const std::string_view name, const std::string_view category, const std::uint64_t begin, const std::uint64_t end)
+  {
+    if (!enabled()) return;
+    auto& buffer = local_buffer();
+    const auto index = buffer.count.load(std::memory_order_relaxed);
+    buffer.spans[index % buffer.spans.size()] = span {name, category, begin, end};
+    buffer.count.store(index + 1, std::memory_order_release);
+  }
+  // Names the calling thread in the trace. Does not allocate the thread's buffer.
+  void set_thread_name(const std::string& name)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto thread   = std::this_thread::get_id();
+    const auto iterator = std::find_if(thread_names_.begin(), thread_names_.end(), [thread] (const auto& entry) { return entry.first == thread; });
+    if (iterator != thread_names_.end())
+      iterator->second = name;
+    else
+      thread_names_.emplace_back(thread, name);
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& buffer : buffers_)
+      buffer->count.store(0, std::memory_order_release);
+  }
+  void write(std::ostream& stream) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::uint64_t origin = (std::numeric_limits<std::uint64_t>::max)();
+    for (auto& buffer : buffers_)
+    {
+      const auto count = buffer->count.load(std::memory_order_acquire);
+      for (auto i = count > buffer->spans.size() ? count - buffer->spans.size() : 0; i < count; ++i)
+        origin = (std::min)(origin, buffer->spans[i % buffer->spans.size()].begin);
+    }
+
+    auto first = true;
+    stream << "{\"traceEvents\":[";
+    for (std::size_t thread = 0; thread < buffers_.size(); ++thread)
+    {
+      auto&      buffer = *buffers_[thread];
+      const auto name   = std::find_if(thread_names_.begin(), thread_names_.end(), [&buffer] (const auto& entry) { return entry.first == buffer.thread; });
+      if (name != thread_names_.end())
+      {
+        stream << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread << ",\"args\":{\"name\":";
+        write_string(stream, name->second);
+        stream << "}}";
+        first = false;
+      }
+
+      const auto count = buffer.count.load(std::memory_order_acquire);
+      for (auto i = count > buffer.spans.size() ? count - buffer.spans.size() : 0; i < count; ++i)
+      {
+        auto& span = buffer.spans[i % buffer.spans.size()];
+        stream << (first ? "" : ",") << "\n{\"name\":";
+        write_string(stream, span.name);
+        stream << ",\"cat\":";
+        write_string(stream, span.category);
+        stream << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread
+               << ",\"ts\":"  << tsc_clock::to_duration(span.begin - origin).count() / 1000.0
+               << ",\"dur\":" << tsc_clock::to_duration(span.end - span.begin).count() / 1000.0 << "}";
+        first = false;
+      }
+    }
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  }
+  void write(const std::string& filename) const
+  {
+    std::ofstream stream(filename);
+    if (!stream)
+      throw std::runtime_error("Failed to open trace file " + filename + ".");
+    write(stream);
+  }
+
+private:
+  struct buffer
+  {
+    buffer(const std::thread::id thread, const std::size_t capacity) : thread(thread), spans((std::max<std::size_t>)(capacity, 1))
+    {
+
+    }
+
+    std::thread::id            thread;
+    std::vector<span>          spans ;
+    std::atomic<std::uint64_t> count {0};
+  };
+  struct thread_cache
+  {
+    std::uint64_t recorder = 0;
+    buffer*       local    = nullptr;
+  };
+
+  static std::uint64_t next_id     ()
+  {
+    static std::atomic<std::uint64_t> counter {1};
+    return counter++;
+  }
+  static void          write_string(std::ostream& stream, const std::string_view string)
+  {
+    stream << '"';
+    for (auto character : string)
+    {
+      if      (character == '"' || character == '\\') stream << '\\' << character;
+      else if (static_cast<unsigned char>(character) >= 0x20) stream << character;
+    }
+    stream << '"';
+  }
+
+  buffer&              local_buffer()
+  {
+    // A single entry per-thread cache covers the common case of one recorder per process; ids are never reused. A thread which alternates
+    // between recorders finds its buffer again under the lock, so that each recorder allocates at most one buffer per thread.
+    thread_local thread_cache cache;
+    if (cache.recorder != id_)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto thread   = std::this_thread::get_id();
+      auto       iterator = std::find_if(buffers_.begin(), buffers_.end(), [thread] (const std::unique_ptr<buffer>& buffer) { return buffer->thread == thread; });
+      if (iterator == buffers_.end())
+        iterator = buffers_.insert(buffers_.end(), std::make_unique<buffer>(thread, capacity_));
+      cache.recorder = id_;
+      cache.local    = iterator->get();
+    }
+    return *cache.local;
+  }
+
+  const std::uint64_t                                  id_           ;
+  const std::size_t                                    capacity_     ;
+  std::atomic<bool>                                    enabled_      {false};
+  std::string                                          exit_filename_;
+  mutable std::mutex                                   mutex_        ;
+  std::vector<std::unique_ptr<buffer>>                 buffers_      ; // One per thread which recorded.
+  std::vector<std::pair<std::thread::id, std::string>> thread_names_ ;
+};
+
+// Trace scope records a span from its construction to its destruction. A null or disabled recorder makes it a no-op.
+class trace_scope final
+{
+public:
+  trace_scope           (trace_recorder* recorder, const std::string_view name, const std::string_view category)
+  : recorder_(recorder && recorder->enabled() ? recorder : nullptr), name_(name), category_(category), begin_(recorder_ ? tsc_clock::ticks() : 0)
+  {
+
+  }
+  trace_scope           (const trace_scope&  that) = delete ;
+  trace_scope           (      trace_scope&& temp) = delete ;
+ ~trace_scope           ()
+  {
+    end();
+  }
+  trace_scope& operator=(const trace_scope&  that) = delete ;
+  trace_scope& operator=(      trace_scope&& temp) = delete ;
+
+  // Ends the span before the scope does.
+  void end()
+  {
+    if (recorder_)
+      recorder_->record(name_, category_, begin_, tsc_clock::ticks());
+    recorder_ = nullptr;
+  }
+
+private:
+  trace_recorder*  recorder_;
+  std::string_view name_    ;
+  std::string_view category_;
+  std::uint64_t    begin_   ;
+};
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef DI_UTILITY_TSC_CLOCK_HPP_
+#define DI_UTILITY_TSC_CLOCK_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define DI_TSC_CLOCK_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define DI_TSC_CLOCK_RDTSC
+#endif
+
+namespace di
+{
+// TSC clock is a steady clock reading the CPU time stamp counter, calibrated once against std::chrono::steady_clock on first use.
+// It assumes an invariant TSC (constant rate, synchronized across cores), as found on all x86 processors of the last decade.
+// Falls back to std::chrono::steady_clock on other architectures.
+class tsc_clock
+{
+public:
+  using rep        = std::int64_t;
+  using period     = std::nano;
+  using duration   = std::chrono::duration<rep, period>;
+  using time_point = std::chrono::time_point<tsc_clock>;
+
+  static constexpr bool is_steady = true;
+
+  static time_point    now             () noexcept
+  {
+#ifdef DI_TSC_CLOCK_RDTSC
+    const auto& calibration = tsc_clock::calibration();
+    return time_point(duration(static_cast<rep>(static_cast<double>(ticks() - calibration.origin) * calibration.nanoseconds_per_tick)));
+#else
+    return time_point(std::chrono::duration_cast<duration>(std::chrono::steady_clock::now().time_since_epoch()));
+#endif
+  }
+  static std::uint64_t ticks           () noexcept
+  {
+#ifdef DI_TSC_CLOCK_RDTSC
+    return static_cast<std::uint64_t>(__rdtsc());
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<duration>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+  }
+  static double        ticks_per_second()
+  {
+    return 1e9 / calibration().nanoseconds_per_tick;
+  }
+  // Converts a difference of ticks() to a duration, which is cheaper than taking the difference of two now().
+  static duration      to_duration     (const std::uint64_t ticks) noexcept
+  {
+    return duration(static_cast<rep>(static_cast<double>(ticks) * calibration().nanoseconds_per_tick));
+  }
+
+private:
+  struct calibration_data
+  {
+    std::uint64_t origin               ;
+    double        nanoseconds_per_tick ;
+  };
+
+  static const calibration_data& calibration()
+  {
+    static const calibration_data calibration = [ ]
+    {
+#ifdef DI_TSC_CLOCK_RDTSC
+      const auto start_time  = std::chrono::steady_clock::now();
+      const auto start_ticks = ticks();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      const auto end_time    = std::chrono::steady_clock::now();
+      const auto end_ticks   = ticks();
+      return calibration_data {start_ticks, std::chrono::duration<double, std::nano>(end_time - start_time).count() / static_cast<double>(end_ticks - start_ticks)};
+#else
+      return calibration_data {0, 1.0};
+#endif
+    }();
+    return calibration;
+  }
+};
+}
+
+#endif
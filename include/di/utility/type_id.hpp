@@ -0,0 +1,51 @@
+#ifndef DI_UTILITY_TYPE_ID_HPP_
+#define DI_UTILITY_TYPE_ID_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <string_view>
+
+namespace di
+{
+// Type ids are dense indices assigned on first use, suitable for indexing flat tables. They do not require RTTI.
+// Each family counts separately, so the tables of one family (e.g. systems) are not sized by the types of another (e.g. events).
+template<typename family = void>
+class type_id_generator
+{
+public:
+  static std::size_t next()
+  {
+    static std::atomic<std::size_t> counter {0};
+    return counter++;
+  }
+};
+
+template<typename type, typename family = void>
+std::size_t type_id()
+{
+  static const std::size_t id = type_id_generator<family>::next();
+  return id;
+}
+
+// Returns the name of the type, extracted from the compiler's function signature macro. Does not require RTTI.
+template<typename type>
+std::string_view type_name()
+{
+#if defined(_MSC_VER)
+  const std::string_view signature = __FUNCSIG__;
+  const auto             begin     = signature.find("type_name<") + 10;
+  const auto             end       = signature.rfind(">(void)");
+#else
+  const std::string_view signature = __PRETTY_FUNCTION__;
+  const auto             begin     = signature.find("type = ") + 7;
+  const auto             end       = signature.find_first_of(";]", begin);
+#endif
+  auto name = signature.substr(begin, end - begin);
+  for (const std::string_view prefix : {"struct ", "class "})
+    if (name.substr(0, prefix.size()) == prefix)
+      name.remove_prefix(prefix.size());
+  return name;
+}
+}
+
+#endif
@@ -1,11 +1,26 @@
 #include "catch.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <memory_resource>
+#include <numeric>
+#include <sstream>
+#include <thread>
 
 #include <di/systems/display/display_system.hpp>
 #include <di/systems/input/input_system.hpp>
+#include <di/systems/input/instance_router.hpp>
+#include <di/systems/input/motion_sampler.hpp>
+#include <di/systems/input/mouse_motion_coalescer.hpp>
+#include <di/systems/input/sdl_event_pump.hpp>
 #include <di/systems/vr/vr_system.hpp>
+#include <di/utility/frame_state.hpp>
+#include <di/utility/signal.hpp>
 #include <di/engine.hpp>
+#include <di/static_engine.hpp>
 
 extern "C"
 {
@@ -21,4 +36,1334 @@ TEST_CASE("Engine is tested.", "[engine]") {
   auto opengl_window = display_system->create_opengl_window("Test", std::array<std::size_t, 2>{32, 32}, std::array<std::size_t, 2>{640, 480});
   input_system ->on_key_press.connect([ ] (di::key key) { std::cout << key.name(); });
   engine.run();
-}
\ No newline at end of file
+}
+TEST_CASE("SDL event pump drains the categories taken and flushes the others from SDL's queue.", "[engine]") {
+  using category = di::sdl_event_category;
+  REQUIRE(di::sdl_event_pump::categorize(SDL_QUIT               ) == category::quit       );
+  REQUIRE(di::sdl_event_pump::categorize(SDL_APP_LOWMEMORY      ) == category::application);
+  REQUIRE(di::sdl_event_pump::categorize(SDL_WINDOWEVENT        ) == category::window     );
+  REQUIRE(di::sdl_event_pump::categorize(SDL_SYSWMEVENT         ) == category::other      );
+  REQUIRE(di::sdl_event_pump::categorize(SDL_MOUSEMOTION        ) == category::input      );
+  REQUIRE(di::sdl_event_pump::categorize(SDL_CLIPBOARDUPDATE    ) == category::input      );
+  REQUIRE(di::sdl_event_pump::categorize(SDL_DROPBEGIN          ) == category::drop       );
+  REQUIRE(di::sdl_event_pump::categorize(SDL_AUDIODEVICEADDED   ) == category::other      );
+  REQUIRE(di::sdl_event_pump::categorize(SDL_RENDER_DEVICE_RESET) == category::render     );
+  REQUIRE(di::sdl_event_pump::categorize(SDL_USEREVENT          ) == category::user       );
+  REQUIRE(di::sdl_event_pump::categorize(SDL_LASTEVENT - 1      ) == category::user       );
+
+  REQUIRE(SDL_InitSubSystem(SDL_INIT_EVENTS) == 0);
+  SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+  const auto push = [ ] (const Uint32 type, const std::size_t count = 1)
+  {
+    SDL_Event event {};
+    event.type = type;
+    for (std::size_t i = 0; i < count; ++i)
+      SDL_PushEvent(&event);
+  };
+
+  auto& pump = di::sdl_event_pump::instance();
+  pump.take(category::window);
+  pump.take(category::input ); // Claimed and taken since the last pass.
+
+  push(SDL_KEYDOWN);
+  push(SDL_AUDIODEVICEADDED);
+  push(SDL_APP_LOWMEMORY);
+  push(SDL_MOUSEMOTION);
+  push(SDL_WINDOWEVENT);
+  push(SDL_USEREVENT);
+  const auto passes = pump.pass_count();
+  const auto input  = pump.take(category::input); // Taken since the last pass: pumps again.
+  REQUIRE(pump.pass_count() == passes + 1);
+  REQUIRE(input.size()      == 2);
+  REQUIRE(input[0].type     == SDL_KEYDOWN    );
+  REQUIRE(input[1].type     == SDL_MOUSEMOTION);
+  const auto window = pump.take(category::window); // Not taken since the last pass: served from it.
+  REQUIRE(pump.pass_count() == passes + 1);
+  REQUIRE(window.size()     == 1);
+  REQUIRE(SDL_HasEvent(SDL_AUDIODEVICEADDED) == SDL_FALSE); // Unclaimed categories are flushed from SDL's queue.
+  REQUIRE(SDL_HasEvent(SDL_APP_LOWMEMORY   ) == SDL_FALSE);
+  REQUIRE(SDL_HasEvent(SDL_USEREVENT       ) == SDL_FALSE);
+
+  // A claimed category is drained instead.
+  pump.take(category::user);
+  push(SDL_USEREVENT);
+  const auto user = pump.take(category::user);
+  REQUIRE(user.size()       == 1);
+  REQUIRE(user[0].type      == SDL_USEREVENT);
+
+  // A category not taken for max_pending events is dropped at the next pass.
+  push(SDL_KEYDOWN, 40000);
+  pump.take(category::window);
+  push(SDL_KEYDOWN, 30000);
+  pump.take(category::window);
+  push(SDL_KEYUP);
+  pump.take(category::window);
+  const auto remaining = pump.take(category::input);
+  REQUIRE(remaining.size()  == 1);
+  REQUIRE(remaining[0].type == SDL_KEYUP);
+
+  SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+  SDL_QuitSubSystem(SDL_INIT_EVENTS);
+}
+
+TEST_CASE("SDL event pump keeps blocking in an idle wait while unclaimed events are queued.", "[engine]") {
+  REQUIRE(SDL_InitSubSystem(SDL_INIT_EVENTS) == 0);
+  SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+  const auto push = [ ] (const Uint32 type)
+  {
+    SDL_Event event {};
+    event.type = type;
+    SDL_PushEvent(&event);
+  };
+  const auto wait = [ ] (const Uint32 kept_type)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    di::sdl_event_pump::instance().wait(std::chrono::milliseconds(50), kept_type);
+    return std::chrono::steady_clock::now() - start;
+  };
+
+  const auto wake_type = SDL_RegisterEvents(1);
+  REQUIRE(wake_type != static_cast<Uint32>(-1));
+  di::sdl_event_pump::instance().take(di::sdl_event_category::input);
+
+  push(SDL_AUDIODEVICEADDED);
+  push(SDL_APP_LOWMEMORY);
+  REQUIRE(wait(wake_type) >= std::chrono::milliseconds(40));
+  REQUIRE(SDL_HasEvent(SDL_AUDIODEVICEADDED) == SDL_FALSE);
+
+  push(wake_type); // The kept type ends the wait and stays queued.
+  REQUIRE(wait(wake_type) <  std::chrono::milliseconds(40));
+  REQUIRE(SDL_HasEvent(wake_type) == SDL_TRUE);
+  SDL_FlushEvent(wake_type);
+
+  push(SDL_KEYDOWN); // So do claimed categories.
+  REQUIRE(wait(wake_type) <  std::chrono::milliseconds(40));
+  REQUIRE(SDL_HasEvent(SDL_KEYDOWN) == SDL_TRUE);
+
+  SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+  SDL_QuitSubSystem(SDL_INIT_EVENTS);
+}
+
+TEST_CASE("Engine schedules systems by their resource dependencies.", "[engine]") {
+  struct writer : di::system
+  {
+    writer() { write_resource("value"); }
+    void tick() override { value = 1; }
+    int value = 0;
+  };
+  struct reader : di::system
+  {
+    reader() { read_resource("value"); }
+    void tick     () override { value = engine_->get_system<writer>()->value; }
+    void post_tick() override { engine_->stop(); }
+    int value = 0;
+  };
+
+  di::engine engine;
+  engine.set_worker_count(4);
+  engine.add_system<writer>();
+  auto reader_system = engine.add_system<reader>();
+  engine.run();
+  REQUIRE(reader_system->value == 1);
+}
+
+TEST_CASE("Engine runs systems after the systems they depend on, even if added later.", "[engine]") {
+  static std::vector<std::string> log;
+  struct last   : di::system
+  {
+    void tick() override { log.push_back("last"); }
+  };
+  struct first  : di::system
+  {
+    first() { depend_on<last>(); }
+    void tick() override { log.push_back("first"); if (log.size() >= 6) engine_->stop(); }
+  };
+  struct middle : di::system
+  {
+    void tick() override { log.push_back("middle"); }
+  };
+
+  for (const auto worker_count : {0, 4})
+  {
+    log.clear();
+    di::engine engine;
+    engine.set_worker_count(worker_count);
+    engine.add_system<first >(); // Depends on a later system, with a system declaring no resources in between.
+    engine.add_system<middle>();
+    engine.add_system<last  >();
+    engine.run();
+    REQUIRE(log == std::vector<std::string>({"middle", "last", "first", "middle", "last", "first"}));
+  }
+
+  struct pong;
+  struct ping : di::system
+  {
+    ping() { depend_on<pong>(); }
+    void tick() override { }
+  };
+  struct pong : di::system
+  {
+    pong() { depend_on<ping>(); }
+    void tick() override { }
+  };
+  di::engine engine;
+  engine.add_system<ping>();
+  engine.add_system<pong>();
+  REQUIRE_THROWS(engine.run());
+}
+
+TEST_CASE("Engine advances simulation systems in fixed time steps.", "[engine]") {
+  struct simulation : di::system
+  {
+    void tick() override { elapsed += delta_time_; ++steps; }
+    di::engine::duration elapsed {0.0F};
+    std::size_t          steps   = 0;
+  };
+  struct render : di::system
+  {
+    render() { set_stage(di::system_stage::render); }
+    void tick() override
+    {
+      REQUIRE(engine_->interpolation() >= 0.0F);
+      REQUIRE(engine_->interpolation() <  1.0F);
+      if (++frames == 100) engine_->stop();
+    }
+    std::size_t frames = 0;
+  };
+
+  di::engine engine;
+  engine.set_fixed_time_step(di::engine::duration(1000.0F / 240.0F), 4);
+  auto simulation_system = engine.add_system<simulation>();
+  engine.add_system<render>();
+  engine.run();
+  REQUIRE(simulation_system->steps <= 400);
+  REQUIRE(simulation_system->elapsed.count() == Approx(simulation_system->steps * 1000.0F / 240.0F).epsilon(0.001));
+}
+
+TEST_CASE("Engine aligns the tick rates of systems added during a fixed step run to the steps taken.", "[engine]") {
+  struct rated : di::system
+  {
+    rated() { set_tick_rate(10.0); }
+    void tick() override { deltas.push_back(delta_time_.count()); }
+    std::vector<float> deltas;
+  };
+  struct render : di::system
+  {
+    render() { set_stage(di::system_stage::render); }
+    void tick() override
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20)); // Steps are capped to 4 ms a frame: the steps fall behind.
+      if (++frames == 50 ) added = engine_->add_system<rated>();
+      if (  frames == 150) engine_->stop();
+    }
+    std::size_t frames = 0;
+    rated*      added  = nullptr;
+  };
+
+  di::engine engine;
+  engine.set_fixed_time_step(di::engine::duration(1.0F), 4);
+  auto render_system = engine.add_system<render>();
+  engine.run();
+
+  // Ticks when added, at the next multiple of the period, then once per period of step time.
+  const auto& deltas = render_system->added->deltas;
+  REQUIRE(deltas.size() >= 4);
+  REQUIRE(deltas[0] >= 0.0F);
+  REQUIRE(deltas[0] <  100.0F);
+  REQUIRE(deltas[1] >  0.0F);
+  REQUIRE(deltas[1] <= 100.0F);
+  for (std::size_t i = 2; i < deltas.size(); ++i)
+    REQUIRE(deltas[i] == Approx(100.0F).margin(0.01));
+}
+
+TEST_CASE("Engine profiles system phases when enabled.", "[engine]") {
+  struct busy : di::system
+  {
+    void tick     () override { std::this_thread::sleep_for(std::chrono::microseconds(100)); }
+    void post_tick() override { if (++frames == 10) engine_->stop(); }
+    std::size_t frames = 0;
+  };
+
+  di::engine engine;
+  engine.add_system<busy>();
+  engine.run();
+  REQUIRE(engine.system_timings<busy>(di::phase::tick).count == 0);
+
+  engine.set_profiling_enabled(true);
+  engine.get_system<busy>()->frames = 0;
+  engine.run();
+  const auto timings = engine.system_timings<busy>(di::phase::tick);
+  REQUIRE(timings.count == 10);
+  REQUIRE(timings.p50   >= std::chrono::microseconds(90));
+  REQUIRE(timings.max   >= timings.p99);
+  REQUIRE(timings.p99   >= timings.p50);
+}
+
+TEST_CASE("Engine records a Chrome trace when enabled.", "[engine]") {
+  struct traced : di::system
+  {
+    void tick     () override { di::trace_scope scope(trace_recorder_, "work", "dispatch"); }
+    void post_tick() override { if (++frames == 3) engine_->stop(); }
+    std::size_t frames = 0;
+  };
+
+  di::engine engine;
+  engine.trace_recorder().set_enabled(true);
+  engine.add_system<traced>();
+  engine.run();
+
+  std::ostringstream stream;
+  engine.trace_recorder().write(stream);
+  const auto trace = stream.str();
+  REQUIRE(trace.find("\"traceEvents\"")       != std::string::npos);
+  REQUIRE(trace.find("\"name\":\"frame\"")    != std::string::npos);
+  REQUIRE(trace.find("\"name\":\"work\"")     != std::string::npos);
+  REQUIRE(trace.find("\"cat\":\"post_tick\"") != std::string::npos);
+}
+TEST_CASE("Trace recorder keeps one buffer per thread across recorders.", "[engine]") {
+  di::trace_recorder first ;
+  di::trace_recorder second;
+  first .set_thread_name("main");
+  second.set_thread_name("main");
+  first .set_enabled(true);
+  second.set_enabled(true);
+  for (std::uint64_t i = 0; i < 100; ++i)
+  {
+    first .record("first" , "test", i, i + 1);
+    second.record("second", "test", i, i + 1);
+  }
+  std::thread([&first] { first.record("worker", "test", 0, 1); }).join();
+
+  std::ostringstream first_stream, second_stream;
+  first .write(first_stream );
+  second.write(second_stream);
+  REQUIRE(first_stream .str().find("\"name\":\"main\"") != std::string::npos);
+  REQUIRE(first_stream .str().find("\"tid\":1")          != std::string::npos);
+  REQUIRE(first_stream .str().find("\"tid\":2")          == std::string::npos);
+  REQUIRE(second_stream.str().find("\"tid\":1")          == std::string::npos);
+}
+
+TEST_CASE("Engine pipelines simulation ahead of rendering.", "[engine]") {
+  struct simulation : di::system
+  {
+    simulation() { write_resource("state"); }
+    void initialize() override { state.resize(engine_->pipeline_depth()); }
+    void tick      () override { state[simulated = frame_index_] = frame_index_; }
+    di::frame_state<std::size_t> state;
+    std::size_t                  simulated = 0;
+  };
+  struct render : di::system
+  {
+    render() { set_stage(di::system_stage::render); set_main_thread_only(true); }
+    void tick      () override
+    {
+      const auto& state = engine_->get_system<simulation>()->state;
+      REQUIRE(state[rendered = frame_index_] == frame_index_);
+      if (++frames == 20) engine_->stop();
+    }
+    std::size_t frames   = 0;
+    std::size_t rendered = 0;
+  };
+
+  di::engine engine;
+  engine.set_worker_count  (2);
+  engine.set_pipeline_depth(3);
+  engine.add_system<simulation>();
+  auto render_system = engine.add_system<render>();
+  engine.run();
+  REQUIRE(render_system->frames                      == 20);
+  REQUIRE(render_system->rendered                    == 19);
+  REQUIRE(engine.get_system<simulation>()->simulated == 21);
+  REQUIRE(engine.frame_latency().count               == 20);
+}
+
+TEST_CASE("Engine constructs deferred systems concurrently.", "[engine]") {
+  struct slow : di::system
+  {
+    explicit slow(const int milliseconds) { write_resource("slow"); std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds)); }
+  };
+  struct slower : di::system
+  {
+    explicit slower(const int milliseconds) { write_resource("slower"); std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds)); }
+    void tick() override { engine_->stop(); }
+  };
+
+  di::engine engine;
+  engine.add_deferred_system<slow  >(100);
+  engine.add_deferred_system<slower>(150);
+  REQUIRE(engine.get_system<slow>() == nullptr);
+  engine.run();
+  REQUIRE(engine.get_system<slow  >() != nullptr);
+  REQUIRE(engine.get_system<slower>() != nullptr);
+
+  const auto& timings = engine.startup_timings();
+  REQUIRE(timings.size()                 == 2);
+  REQUIRE(timings[0].name.find("slow"  ) != std::string_view::npos);
+  REQUIRE(timings[1].name.find("slower") != std::string_view::npos);
+  REQUIRE(timings[0].construction        >= std::chrono::milliseconds(100));
+  REQUIRE(timings[1].construction        >= std::chrono::milliseconds(150));
+  REQUIRE(engine.startup_duration()      <  std::chrono::milliseconds(250));
+}
+
+TEST_CASE("Engine applies system changes requested during a frame at the frame boundary.", "[engine]") {
+  using hook_counts = std::array<std::size_t, 3>; // initialize, tick, terminate
+  struct loaded : di::system
+  {
+    explicit loaded(hook_counts* counts) : counts(counts) { }
+    void initialize() override { ++(*counts)[0]; }
+    void tick      () override { ++(*counts)[1]; }
+    void terminate () override { ++(*counts)[2]; }
+    hook_counts* counts;
+  };
+  struct loader : di::system
+  {
+    void tick() override
+    {
+      if      (++frames == 1) { engine_->add_system<loaded>(&loaded_counts); REQUIRE(engine_->get_system<loaded>() == nullptr); }
+      else if (  frames == 2)   REQUIRE(engine_->get_system<loaded>() != nullptr);
+      else if (  frames == 3)   engine_->remove_system<loaded>();
+      else if (  frames == 5)   engine_->stop();
+    }
+    std::size_t frames        = 0;
+    hook_counts loaded_counts {};
+  };
+
+  di::engine engine;
+  auto loader_system = engine.add_system<loader>();
+  engine.run();
+  REQUIRE(engine.get_system<loaded>() == nullptr);
+  REQUIRE(loader_system->loaded_counts == (hook_counts {1, 2, 1}));
+}
+
+TEST_CASE("Engine looks systems up by their type ids.", "[engine]") {
+  struct first  : di::system { };
+  struct event  { };
+  struct second : di::system { };
+  struct third  : di::system { };
+
+  // Systems count their type ids apart from events, so event types do not widen the table of systems.
+  const auto first_id = di::type_id<first, di::system>();
+  di::type_id<event>();
+  REQUIRE((di::type_id<second, di::system>() == first_id + 1));
+  REQUIRE((di::type_id<third , di::system>() == first_id + 2));
+
+  di::engine engine;
+  REQUIRE(engine.get_system<first>() == nullptr);
+
+  const auto first_system = engine.add_system<first>();
+  const auto third_system = engine.add_system<third>();
+  REQUIRE(engine.get_system<first >() == first_system);
+  REQUIRE(engine.get_system<second>() == nullptr);
+  REQUIRE(engine.get_system<third >() == third_system);
+
+  engine.remove_system<first>(); // Leaves the system with the higher id in place.
+  REQUIRE(engine.get_system<first >() == nullptr);
+  REQUIRE(engine.get_system<third >() == third_system);
+
+  const auto second_system = engine.add_system<second>();
+  const auto readded       = engine.add_system<first >();
+  REQUIRE(engine.get_system<first >() == readded      );
+  REQUIRE(engine.get_system<second>() == second_system);
+  REQUIRE(engine.get_system<third >() == third_system );
+
+  engine.remove_system<third>();
+  engine.remove_system<second>();
+  REQUIRE(engine.get_system<first >() == readded);
+  REQUIRE(engine.get_system<second>() == nullptr);
+  REQUIRE(engine.get_system<third >() == nullptr);
+}
+
+#ifdef DI_FRAME_TASKS
+TEST_CASE("Engine resumes frame tasks at frame boundaries.", "[engine]") {
+  struct scripted : di::system
+  {
+    void initialize() override { engine_->spawn(script()); }
+    void tick      () override { ++frames; if (frames == 3) on_event(42); if (frames == 10) engine_->stop(); }
+
+    di::frame_task script()
+    {
+      log.push_back(frames);
+      co_await di::next_frame ();
+      log.push_back(frames);
+      co_await di::after_phase(di::phase::post_tick);
+      log.push_back(frames);
+      co_await di::wait_signal(on_event);
+      log.push_back(frames);
+      co_await di::wait_for   (std::chrono::milliseconds(0));
+      log.push_back(frames);
+    }
+
+    std::size_t              frames   = 0;
+    std::vector<std::size_t> log      ;
+    di::signal<void(int)>    on_event ;
+  };
+
+  di::engine engine;
+  auto system = engine.add_system<scripted>();
+  engine.run();
+  REQUIRE(system->log == (std::vector<std::size_t> {0, 0, 1, 3, 3}));
+}
+TEST_CASE("Engine resumes frame tasks at the end of custom phases.", "[engine]") {
+  struct scripted : di::system
+  {
+    void initialize() override { engine_->spawn(script()); }
+    void tick      () override { if (++frames == 3) engine_->stop(); }
+
+    di::frame_task script()
+    {
+      co_await di::after_phase(late);
+      log.push_back(frames);
+      co_await di::after_phase(late);
+      log.push_back(frames);
+    }
+
+    di::phase                late   = di::phase::post_tick;
+    std::size_t              frames = 0;
+    std::vector<std::size_t> log    ;
+  };
+
+  di::engine engine;
+  const auto late   = engine.add_phase("late", di::phase::post_tick);
+  auto       system = engine.add_system<scripted>();
+  system->late = late;
+  engine.run();
+  REQUIRE(system->log == (std::vector<std::size_t> {1, 2}));
+}
+TEST_CASE("Frame scheduler resumes all due tasks before rethrowing the exception of one.", "[engine]") {
+  struct script
+  {
+    di::frame_task run(const bool fail) { co_await di::next_frame(); ++resumptions; if (fail) throw std::runtime_error("Script failed."); }
+
+    std::size_t resumptions = 0;
+  };
+
+  di::frame_scheduler scheduler;
+  script              scripts[3];
+  scripts[0].run(false).start(scheduler);
+  scripts[1].run(true ).start(scheduler);
+  scripts[2].run(false).start(scheduler);
+  REQUIRE_THROWS_AS(scheduler.begin_frame(), std::runtime_error);
+  REQUIRE(scripts[0].resumptions == 1);
+  REQUIRE(scripts[1].resumptions == 1);
+  REQUIRE(scripts[2].resumptions == 1);
+  REQUIRE(scheduler.task_count() == 0);
+  REQUIRE_NOTHROW(scheduler.begin_frame());
+}
+TEST_CASE("Signal awaiter ignores calls of its slot after the task resumed or was destroyed.", "[engine]") {
+  // Keeps calling disconnected slots, as an emission on another thread which began before the disconnection may.
+  struct lingering_signal
+  {
+    struct connection { void disconnect() { } };
+
+    connection connect   (std::function<void()> function) { slots.push_back(std::move(function)); return {}; }
+    void       operator()()                               { for (auto& slot : slots) slot(); }
+
+    std::vector<std::function<void()>> slots;
+  };
+  struct script
+  {
+    di::frame_task run() { co_await di::wait_signal(signal); ++resumptions; }
+
+    lingering_signal signal     ;
+    std::size_t      resumptions = 0;
+  };
+
+  di::frame_scheduler scheduler;
+  script              completed;
+  completed.run().start(scheduler);
+  completed.signal();
+  scheduler.begin_frame();
+  REQUIRE(completed.resumptions == 1);
+  REQUIRE(scheduler.task_count() == 0);
+  completed.signal(); // The task and its awaiter are gone.
+  scheduler.begin_frame();
+  REQUIRE(completed.resumptions == 1);
+
+  script destroyed;
+  {
+    di::frame_scheduler other;
+    destroyed.run().start(other);
+  }
+  destroyed.signal(); // The scheduler destroyed the waiting task.
+  REQUIRE(destroyed.resumptions == 0);
+}
+#endif
+
+TEST_CASE("Engine blocks between frames in idle mode.", "[engine]") {
+  struct counter : di::system
+  {
+    void tick() override { ++frames; }
+    std::size_t frames = 0;
+  };
+
+  di::engine engine;
+  engine.set_idle_mode   (true);
+  engine.set_idle_timeout(std::chrono::milliseconds(50));
+  auto system = engine.add_system<counter>();
+  std::thread waker([&]
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    engine.stop();
+    engine.wake();
+  });
+  const auto start = std::chrono::steady_clock::now();
+  engine.run ();
+  waker .join();
+  REQUIRE(std::chrono::steady_clock::now() - start <  std::chrono::milliseconds(300));
+  REQUIRE(system->frames                           >= 3);
+  REQUIRE(system->frames                           <= 6);
+}
+
+TEST_CASE("Engine ticks systems at their own rates.", "[engine]") {
+  struct rated : di::system
+  {
+    explicit rated(const std::size_t divisor, const double frequency = 0.0)
+    {
+      write_resource(std::to_string(divisor) + "/" + std::to_string(frequency));
+      if (frequency > 0.0) set_tick_rate(frequency); else set_tick_divisor(divisor);
+    }
+    void tick() override
+    {
+      frames.push_back(frame_index_);
+      deltas.push_back(delta_time_.count());
+      if (frame_index_ == 400) engine_->stop();
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    std::vector<std::size_t> frames;
+    std::vector<float>       deltas;
+  };
+
+  di::engine engine;
+  auto every   = engine.add_system<rated>(1);
+  auto half    = engine.add_system<rated>(2);
+  auto quarter = engine.add_system<rated>(4);
+  auto slow    = engine.add_system<rated>(1, 50.0);
+  engine.run();
+
+  REQUIRE(half   ->frames.size() == 201);
+  REQUIRE(quarter->frames.size() == 101);
+  for (auto frame : quarter->frames)
+    REQUIRE(std::find(half->frames.begin(), half->frames.end(), frame) != half->frames.end());
+  for (std::size_t i = 1; i < quarter->frames.size(); ++i)
+  {
+    auto sum = 0.0F;
+    for (auto frame = quarter->frames[i - 1] + 1; frame <= quarter->frames[i]; ++frame)
+      sum += every->deltas[frame];
+    REQUIRE(quarter->deltas[i] == Approx(sum).epsilon(0.01));
+  }
+
+  auto elapsed = 0.0F;
+  for (auto delta : every->deltas)
+    elapsed += delta;
+  REQUIRE(slow->frames.size() == Approx(elapsed / 20.0F).margin(1.5));
+}
+
+TEST_CASE("Engine dispatches only the overridden hooks and custom phases.", "[engine]") {
+  struct ticker : di::system
+  {
+    explicit ticker(std::vector<std::string>* log) : log(log)
+    {
+      add_phase_hook("late", [this] { this->log->push_back("late"); });
+    }
+    void tick     () override { log->push_back("tick"); }
+    void post_tick() override { log->push_back("post_tick"); if (log->size() >= 12) engine_->stop(); }
+    std::vector<std::string>* log;
+  };
+  struct later : di::system
+  {
+    explicit later(std::vector<std::string>* log)
+    {
+      add_phase_hook("later", [log] { log->push_back("later"); });
+    }
+  };
+  static_assert(di::overridden_hooks<ticker>    () == (di::hook_bit(di::system_hook::tick) | di::hook_bit(di::system_hook::post_tick)), "");
+  static_assert(di::overridden_hooks<later>     () == 0, "");
+  static_assert(di::overridden_hooks<di::system>() == 0, "");
+  static_assert(di::phase_hook_of(di::phase::pre_tick ) == di::system_hook::pre_tick , "");
+  static_assert(di::phase_hook_of(di::phase::post_tick) == di::system_hook::post_tick, "");
+
+  std::vector<std::string> log;
+  di::engine engine;
+  engine.set_profiling_enabled(true);
+  engine.add_system<ticker>(&log);
+  engine.add_system<later >(&log);
+  const auto late = engine.add_phase("late" , di::phase::tick);
+  REQUIRE(engine.add_phase("later", late) != late);
+  REQUIRE(engine.add_phase("late" , di::phase::pre_tick) == late);
+  REQUIRE(engine.phases().size() == 5);
+  REQUIRE(engine.phases()[2] == late);
+  REQUIRE_THROWS(engine.add_phase("never", static_cast<di::phase>(42)));
+  engine.run();
+
+  REQUIRE(log.size() == 12);
+  for (std::size_t i = 0; i < log.size(); i += 4)
+  {
+    REQUIRE(log[i    ] == "tick"     );
+    REQUIRE(log[i + 1] == "late"     );
+    REQUIRE(log[i + 2] == "later"    );
+    REQUIRE(log[i + 3] == "post_tick");
+  }
+  REQUIRE(engine.system_timings<ticker>(di::phase::pre_tick ).count == 0);
+  REQUIRE(engine.system_timings<ticker>(di::phase::tick     ).count == 3);
+  REQUIRE(engine.system_timings<later >(di::phase::tick     ).count == 0);
+  REQUIRE(engine.system_timings<ticker>(late                ).count == 0);
+}
+
+TEST_CASE("Static engine runs the overridden hooks in order and is stopped by its systems.", "[engine]") {
+  static std::vector<std::string> log;
+  struct first  : di::system
+  {
+    void initialize() override { log.push_back("initialize"); }
+    void tick      () override { log.push_back("first"); }
+  };
+  struct second : di::system
+  {
+    void post_tick () override { log.push_back("second"); if (++frames == 3) stop_engine(); }
+    void terminate () override { log.push_back("terminate"); }
+    std::size_t frames = 0;
+  };
+  struct hidden : di::system
+  {
+  protected:
+    void tick      () override { log.push_back("hidden"); }
+  };
+
+  log.clear();
+  di::static_engine<first, second, hidden> engine;
+  engine.run();
+
+  REQUIRE(!engine.is_running());
+  REQUIRE(log.size() == 11);
+  REQUIRE(log.front() == "initialize");
+  for (std::size_t i = 1; i < 10; i += 3)
+  {
+    REQUIRE(log[i    ] == "first" );
+    REQUIRE(log[i + 1] == "hidden");
+    REQUIRE(log[i + 2] == "second");
+  }
+  REQUIRE(log.back () == "terminate");
+}
+
+TEST_CASE("Frame arena stops allocating from upstream once it has grown to the peak frame.", "[engine]") {
+  struct counting_resource : std::pmr::memory_resource
+  {
+    void* do_allocate  (const std::size_t bytes, const std::size_t alignment) override
+    {
+      ++allocations;
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void  do_deallocate(void* pointer, const std::size_t bytes, const std::size_t alignment) override
+    {
+      std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+    bool  do_is_equal  (const std::pmr::memory_resource& that) const noexcept override
+    {
+      return this == &that;
+    }
+    std::size_t allocations = 0;
+  };
+
+  counting_resource upstream;
+  di::frame_arena   arena(64, &upstream);
+  std::vector<std::size_t> allocations;
+  for (auto frame = 0; frame < 4; ++frame)
+  {
+    std::pmr::vector<double> values(&arena);
+    for (auto i = 0; i < 100; ++i)
+      values.push_back(i);
+    REQUIRE(values.back() == 99.0);
+    allocations.push_back(upstream.allocations);
+    arena.reset();
+  }
+  REQUIRE(allocations[0] >  1);
+  REQUIRE(allocations[1] == allocations[0] + 1); // The grown block.
+  REQUIRE(allocations[3] == allocations[1]);
+  REQUIRE(arena.size()   == 0);
+
+  struct scratch : di::system
+  {
+    void tick() override
+    {
+      std::pmr::vector<int> values(&engine_->frame_memory());
+      values.resize(1000);
+      sizes.push_back(engine_->frame_memory().size());
+      if (sizes.size() == 10) engine_->stop();
+    }
+    std::vector<std::size_t> sizes;
+  };
+
+  di::engine engine;
+  auto system = engine.add_system<scratch>();
+  engine.run();
+  REQUIRE(std::all_of(system->sizes.begin(), system->sizes.end(), [] (const std::size_t size) { return size == 1000 * sizeof(int); }));
+  REQUIRE(engine.frame_memory().overflow_count() == 0);
+}
+
+TEST_CASE("Engine runs jobs of systems on its workers.", "[engine]") {
+  struct fan_out : di::system
+  {
+    void tick() override
+    {
+      std::vector<std::size_t> values(1000);
+      engine_->jobs().parallel_for(0, values.size(), 16, [&] (const std::size_t i) { values[i] = i; });
+      sums.push_back(std::accumulate(values.begin(), values.end(), std::size_t(0)));
+
+      std::atomic<std::size_t> jobs {0};
+      std::size_t              seen = 0;
+      di::task_group group(engine_->jobs());
+      for (auto i = 0; i < 8; ++i)
+        group.run([&] { std::this_thread::sleep_for(std::chrono::microseconds(100)); ++jobs; });
+      group.then([&] { seen = jobs; });
+      group.wait();
+      continuations.push_back(seen);
+
+      if (sums.size() == 20) engine_->stop();
+    }
+    std::vector<std::size_t> sums         ;
+    std::vector<std::size_t> continuations;
+  };
+
+  for (auto workers : {0, 3})
+  {
+    di::engine engine;
+    auto system = engine.add_system<fan_out>();
+    engine.set_worker_count(workers);
+    engine.run();
+    REQUIRE(std::all_of(system->sums         .begin(), system->sums         .end(), [] (const std::size_t sum ) { return sum  == 999 * 1000 / 2; }));
+    REQUIRE(std::all_of(system->continuations.begin(), system->continuations.end(), [] (const std::size_t seen) { return seen == 8; }));
+    REQUIRE(engine.job_wait_time().count == 20);
+    if (workers > 0)
+      REQUIRE(engine.job_wait_time().max > std::chrono::nanoseconds(0));
+  }
+}
+
+TEST_CASE("Engine dumps the frames around a hitch.", "[engine]") {
+  struct hitching : di::system
+  {
+    void tick() override
+    {
+      const auto channel = flight_recorder_->channel("hitching/work items");
+      flight_recorder_->add(channel, 3.0);
+      if (frame_index_ == 30) std::this_thread::sleep_for(std::chrono::milliseconds(40));
+      if (frame_index_ == 60) engine_->stop();
+    }
+  };
+
+  di::engine engine;
+  engine.add_system<hitching>();
+  engine.set_worker_count(2); // Dumps are written by a worker.
+  engine.flight_recorder().set_enabled        (true);
+  engine.flight_recorder().set_threshold      (std::chrono::milliseconds(20));
+  engine.flight_recorder().set_post_frames    (5);
+  engine.flight_recorder().set_filename_prefix("engine_test_hitch_");
+  engine.run();
+
+  REQUIRE(engine.flight_recorder().dumps().size() == 1);
+  REQUIRE(engine.flight_recorder().dumps()[0]     == "engine_test_hitch_30.difr");
+  REQUIRE(engine.flight_recorder().failure_count() == 0);
+
+  std::ifstream stream(engine.flight_recorder().dumps()[0], std::ios::binary);
+  const auto dump = di::flight_recorder::read(stream);
+  REQUIRE(dump.hitch_frame      == 30);
+  REQUIRE(dump.threshold        == 20.0);
+  REQUIRE(dump.frames.size()    == 36);
+  REQUIRE(dump.frames.front()   == 0);
+  REQUIRE(dump.frames.back()    == 35);
+
+  const auto channel = [&dump] (const std::string& name)
+  {
+    return std::find_if(dump.channels.begin(), dump.channels.end(), [&name] (const std::string& channel)
+    {
+      return channel.size() >= name.size() && channel.compare(channel.size() - name.size(), name.size(), name) == 0;
+    }) - dump.channels.begin();
+  };
+  REQUIRE(channel("hitching/tick")       < dump.channels.size());
+  REQUIRE(channel("hitching/work items") < dump.channels.size());
+  REQUIRE(channel("engine/job wait")     < dump.channels.size());
+  REQUIRE(dump.value(30, di::flight_recorder::frame_time_channel) >= 40.0);
+  REQUIRE(dump.value(30, channel("hitching/tick"))                >= 40.0);
+  REQUIRE(dump.value(29, channel("hitching/tick"))                <  20.0);
+  REQUIRE(dump.value(30, channel("hitching/work items"))          == 3.0);
+  stream.close();
+  std::remove(engine.flight_recorder().dumps()[0].c_str());
+}
+TEST_CASE("Flight recorder drops what it cannot record instead of throwing.", "[engine]") {
+  di::flight_recorder recorder(4, 2);
+  recorder.set_enabled        (true);
+  recorder.set_post_frames    (0);
+  recorder.set_filename_prefix("engine_test_missing_directory/hitch_");
+  const auto kept      = recorder.channel("kept");
+  const auto discarded = recorder.channel("discarded");
+  REQUIRE(kept      == 1);
+  REQUIRE(discarded == di::flight_recorder::discard_channel);
+
+  recorder.begin_frame(0);
+  recorder.add(kept     , 1.0);
+  recorder.add(discarded, 1.0);
+  REQUIRE(recorder.end_frame(recorder.threshold() * 2.0)); // Captured, not written yet.
+  REQUIRE(recorder.failure_count() == 0);
+  REQUIRE_NOTHROW(recorder.write_dumps());
+  REQUIRE(recorder.dumps().empty());
+  REQUIRE(recorder.failure_count() == 1);
+}
+
+struct manual_clock
+{
+  using rep        = std::int64_t;
+  using period     = std::micro;
+  using duration   = std::chrono::duration<rep, period>;
+  using time_point = std::chrono::time_point<manual_clock>;
+  static constexpr bool is_steady = true;
+  static time_point now() { return time_point(duration(current)); }
+  static inline rep current = 0;
+};
+
+TEST_CASE("Thread pool wakes its sleeping workers and drains its tasks before joining.", "[engine]") {
+  std::atomic<std::size_t> count {0};
+  {
+    di::thread_pool pool(4);
+    for (auto round = 1; round <= 3; ++round)
+    {
+      // Lets the workers run dry and go to sleep, so that the submissions have to wake them.
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      for (auto i = 0; i < 1000; ++i)
+        pool.submit([&count] { count.fetch_add(1); });
+      while (count.load() < round * 1000u)
+        if (!pool.run_one())
+          std::this_thread::yield();
+      REQUIRE(count.load() == round * 1000u);
+    }
+    for (auto i = 0; i < 1000; ++i)
+      pool.submit([&count] { count.fetch_add(1); });
+  }
+  REQUIRE(count.load() == 4000);
+}
+TEST_CASE("Frame timer keeps rolling frame time statistics.", "[engine]") {
+  di::frame_timer<float, std::milli, manual_clock> timer(4);
+  for (auto frame_time : {10000, 20000, 10000, 20000, 30000, 30000, 30000})
+  {
+    manual_clock::current += frame_time;
+    timer.tick();
+  }
+  REQUIRE(timer.delta_time().count() == Approx(30.0F));
+
+  // The window holds 20, 30, 30 and 30 ms.
+  auto statistics = timer.statistics();
+  REQUIRE(statistics.count                      == 4);
+  REQUIRE(statistics.mean              .count() == Approx(27.5));
+  REQUIRE(statistics.standard_deviation.count() == Approx(5.0));
+  REQUIRE(statistics.jitter            .count() == Approx(10.0 / 3.0));
+  REQUIRE(statistics.p50               .count() == Approx(30.0).epsilon(0.125));
+  REQUIRE(statistics.p99               .count() == Approx(30.0).epsilon(0.125));
+
+  timer.reset_statistics();
+  REQUIRE(timer.statistics().count == 0);
+
+  di::engine engine;
+  struct counter : di::system
+  {
+    void tick() override { if (++frames == 50) engine_->stop(); std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+    std::size_t frames = 0;
+  };
+  engine.add_system<counter>();
+  engine.set_frame_statistics_window(32);
+  engine.run();
+  statistics = engine.frame_time_statistics();
+  REQUIRE(statistics.count                     == 32);
+  REQUIRE(statistics.mean             .count() >= 1.0);
+  REQUIRE(statistics.p50              .count() >= 0.875);
+}
+
+TEST_CASE("Frame limiter paces frames and counts the periods skipped by late frames.", "[engine]") {
+  di::frame_limiter limiter(500.0); // 2 ms period.
+  limiter.wait(); // Sets the first deadline.
+  for (auto i = 0; i < 5; ++i)
+    limiter.wait();
+  const auto frames = limiter.statistics().frame_count;
+  const auto missed = limiter.statistics().missed_count;
+  REQUIRE(frames + missed >= 5); // More when the thread was descheduled for longer than a period.
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(11)); // At least four whole periods past the deadline.
+  const auto start = std::chrono::steady_clock::now();
+  limiter.wait();
+  REQUIRE(limiter.statistics().missed_count >= missed + 5);
+  REQUIRE(limiter.statistics().frame_count  == frames);
+
+  limiter.wait(); // Resynchronized: the deadline is a whole period after the late frame instead of long past.
+  REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(2));
+
+  const auto statistics = limiter.statistics();
+  limiter.set_target_frame_rate(0.0);
+  limiter.wait();
+  REQUIRE(limiter.statistics().frame_count  == statistics.frame_count );
+  REQUIRE(limiter.statistics().missed_count == statistics.missed_count);
+}
+
+TEST_CASE("Timer wheel runs delayed and periodic callbacks.", "[engine]") {
+  using milliseconds = di::timer_wheel::duration;
+
+  di::timer_wheel          wheel;
+  std::vector<double>      fired;
+  std::vector<double>      ticks;
+  const auto record = [&] { fired.push_back(wheel.time().count()); };
+
+  wheel.schedule(milliseconds(5.0    ), record);
+  wheel.schedule(milliseconds(100.0  ), record);
+  wheel.schedule(milliseconds(70000.0), record); // Beyond the second wheel.
+  wheel.schedule(milliseconds(2.0e7  ), record); // Beyond the outermost wheel.
+  const auto cancelled = wheel.schedule(milliseconds(50.0), record);
+  const auto periodic  = wheel.schedule_periodic(milliseconds(10.0), [&]
+  {
+    ticks.push_back(wheel.time().count());
+    if (ticks.size() == 5) wheel.schedule(milliseconds(1.0), record); // Scheduling from a callback.
+  });
+  REQUIRE(wheel.size() == 6);
+  REQUIRE(wheel.next_expiry() == milliseconds(5.0));
+  REQUIRE(wheel.cancel(cancelled));
+  REQUIRE(!wheel.cancel(cancelled));
+  REQUIRE(!wheel.is_scheduled(cancelled));
+
+  for (auto i = 0; i < 8; ++i)
+    wheel.advance(milliseconds(16.0));
+  REQUIRE(fired == std::vector<double>({16.0, 96.0, 112.0}));
+  REQUIRE(ticks == std::vector<double>({16.0, 32.0, 48.0, 64.0, 80.0, 96.0, 112.0, 128.0}));
+  REQUIRE(wheel.is_scheduled(periodic));
+
+  REQUIRE(wheel.cancel(periodic));
+  wheel.advance(milliseconds(70000.0 - 128.0 - 1.0));
+  REQUIRE(fired.size() == 3);
+  REQUIRE(wheel.next_expiry() <= milliseconds(1.0));
+  wheel.advance(milliseconds(1.0));
+  REQUIRE(fired.back() == 70000.0);
+  wheel.advance(milliseconds(2.0e7 - 70000.0));
+  REQUIRE(fired.back() == 2.0e7);
+  REQUIRE(wheel.size() == 0);
+  REQUIRE(wheel.next_expiry() == (milliseconds::max)());
+
+  struct pulser : di::system
+  {
+    void initialize() override
+    {
+      engine_->timers().schedule_periodic(std::chrono::milliseconds(2), [this] { if (++pulses == 10) engine_->stop(); });
+    }
+    std::size_t pulses = 0;
+  };
+
+  di::engine engine;
+  engine.set_idle_mode(true); // Idle waits end at the next timer.
+  const auto pulses = engine.add_system<pulser>();
+  const auto start  = std::chrono::steady_clock::now();
+  engine.run();
+  REQUIRE(pulses->pulses == 10);
+  REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(400));
+  engine.timers().clear();
+}
+
+TEST_CASE("Engine delivers events posted from other threads in batches.", "[engine]") {
+  struct sample
+  {
+    std::size_t producer = 0;
+    std::size_t sequence = 0;
+  };
+  constexpr std::size_t producer_count = 4;
+  constexpr std::size_t sample_count   = 20000;
+
+  struct consumer : di::system
+  {
+    void initialize() override
+    {
+      engine_->events().subscribe<sample>(di::phase::tick, [this] (di::span<const sample> samples)
+      {
+        ++batches;
+        for (auto& sample : samples)
+        {
+          if (sample.sequence != next[sample.producer]++) ordered = false;
+          ++received;
+        }
+      });
+    }
+    void post_tick () override
+    {
+      if (received == producer_count * sample_count) engine_->stop();
+    }
+    std::array<std::size_t, producer_count> next     {};
+    std::size_t                             received = 0;
+    std::size_t                             batches  = 0;
+    bool                                    ordered  = true;
+  };
+
+  di::engine engine;
+  engine.set_worker_count(2);
+  const auto system = engine.add_system<consumer>();
+
+  std::vector<std::thread> producers;
+  for (std::size_t producer = 0; producer < producer_count; ++producer)
+    producers.emplace_back([&engine, producer]
+    {
+      for (std::size_t i = 0; i < sample_count; ++i)
+        engine.events().post(sample {producer, i});
+    });
+  engine.run();
+  for (auto& producer : producers)
+    producer.join();
+
+  REQUIRE(system->received == producer_count * sample_count);
+  REQUIRE(system->ordered);
+  REQUIRE(system->batches  >= 1);
+  REQUIRE_THROWS(engine.events().subscribe<sample>(di::phase::post_tick, [] (di::span<const sample>) { }));
+
+  di::event_queue<int> queue(4);
+  std::vector<int>     batch;
+  for (auto i = 0; i < 10; ++i)
+    queue.post(i);
+  REQUIRE(queue.overflow_count() == 6);
+  queue.drain(batch);
+  REQUIRE(batch == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+  engine.events().post(1.5F);
+  engine.events().post(2.5F);
+  const auto floats = engine.events().drain<float>();
+  REQUIRE(floats.size() == 2);
+  REQUIRE(floats[1]     == 2.5F);
+  REQUIRE(engine.events().drain<float>().empty());
+}
+
+TEST_CASE("Event queue delivers overflowed events after the ring events still being written.", "[engine]") {
+  // Moving an event with a gate into its slot blocks until the gate opens, stalling its producer mid-write.
+  struct gated
+  {
+    gated           () = default;
+    gated           (const int value, std::atomic<bool>* entered = nullptr, std::atomic<bool>* gate = nullptr) : value(value), entered(entered), gate(gate) { }
+    gated           (gated&& temp) = default;
+    gated& operator=(gated&& temp)
+    {
+      if (temp.gate)
+      {
+        temp.entered->store(true);
+        while (!temp.gate->load())
+          std::this_thread::yield();
+      }
+      value = temp.value;
+      return *this;
+    }
+
+    int                value   = 0;
+    std::atomic<bool>* entered = nullptr;
+    std::atomic<bool>* gate    = nullptr;
+  };
+
+  di::event_queue<gated> queue(4);
+  std::atomic<bool>      entered {false};
+  std::atomic<bool>      gate    {false};
+  std::thread            stalled([&] { queue.post(gated(0, &entered, &gate)); });
+  while (!entered.load())
+    std::this_thread::yield();
+  for (auto i = 1; i < 5; ++i)
+    queue.post(gated(i)); // 4 overflows.
+  REQUIRE(queue.overflow_count() == 1);
+
+  std::vector<gated> batch;
+  queue.drain(batch);
+  REQUIRE(batch.empty());
+
+  gate.store(true);
+  stalled.join();
+  queue.drain(batch);
+  REQUIRE(batch.size() == 5);
+  for (auto i = 0; i < 5; ++i)
+    REQUIRE(batch[i].value == i);
+}
+
+TEST_CASE("Signal calls its slots in connection order until they are disconnected.", "[engine]") {
+  const auto check = [ ] (auto& signal)
+  {
+    std::vector<int> calls;
+    std::array<char, 64> payload {}; // Exceeds the inline storage of a slot.
+    auto first  = signal.connect([&calls] (int value) { calls.push_back(value); });
+    auto second = signal.connect([&calls, payload] (int value) { calls.push_back(value * 10 + payload[0]); });
+    signal(1);
+    REQUIRE(calls == std::vector<int>({1, 10}));
+
+    {
+      di::scoped_connection scoped = signal.connect([&calls] (int) { calls.push_back(-1); });
+      std::vector<di::connection> more;
+      for (auto i = 0; i < 8; ++i) // Exceeds the inline slots of an unsynchronized signal.
+        more.push_back(signal.connect([&calls, i] (int) { calls.push_back(100 + i); }));
+      more[3].disconnect();
+      calls.clear();
+      signal(2);
+      REQUIRE(calls == std::vector<int>({2, 20, -1, 100, 101, 102, 104, 105, 106, 107}));
+      for (auto& connection : more)
+        connection.disconnect();
+    }
+    REQUIRE(signal.num_slots() == 2);
+
+    // Slots disconnected or connected during an emission take effect after it.
+    di::connection self;
+    self = signal.connect([&] (int) { self.disconnect(); signal.connect([&calls] (int) { calls.push_back(7); }); });
+    calls.clear();
+    signal(3);
+    REQUIRE(calls == std::vector<int>({3, 30}));
+    REQUIRE(!self.connected());
+    calls.clear();
+    signal(4);
+    REQUIRE(calls == std::vector<int>({4, 40, 7}));
+
+    second.disconnect();
+    REQUIRE( first .connected());
+    REQUIRE(!second.connected());
+    signal.disconnect_all_slots();
+    REQUIRE(signal.empty());
+    REQUIRE(!first.connected());
+  };
+
+  di::signal<void(int), di::unsynchronized_signal_policy> unsynchronized;
+  di::signal<void(int), di::synchronized_signal_policy>   synchronized  ;
+  check(unsynchronized);
+  check(synchronized  );
+
+  di::connection orphan;
+  {
+    di::signal<void(const std::string&)> signal;
+    orphan = signal.connect([ ] (const std::string&) { });
+  }
+  orphan.disconnect();
+  REQUIRE(!orphan.connected());
+
+  // Emission on other threads while slots come and go.
+  std::atomic<bool>        stop  {false};
+  std::atomic<std::size_t> calls {0};
+  std::vector<std::thread> emitters;
+  for (auto i = 0; i < 2; ++i)
+    emitters.emplace_back([&] { while (!stop.load()) synchronized(1); });
+  for (auto i = 0; i < 1000; ++i)
+  {
+    di::scoped_connection connection = synchronized.connect([&calls] (int value) { calls += static_cast<std::size_t>(value); });
+    synchronized(1);
+  }
+  stop = true;
+  for (auto& emitter : emitters)
+    emitter.join();
+  REQUIRE(calls.load() >= 1000);
+  REQUIRE(synchronized.empty());
+}
+
+TEST_CASE("Mouse motion coalescer sums the motion of each window and mouse between flushes.", "[engine]") {
+  using motion = di::mouse_motion_coalescer::motion;
+  std::vector<std::string> dispatched;
+  const auto record = [&dispatched] (const motion& motion)
+  {
+    dispatched.push_back(std::to_string(motion.window) + "/" + std::to_string(motion.mouse) + " at " + std::to_string(motion.position[0]) + "," + std::to_string(motion.position[1]) + " by " + std::to_string(motion.delta[0]) + "," + std::to_string(motion.delta[1]));
+  };
+  constexpr std::uint32_t touch_mouse = static_cast<std::uint32_t>(-1);
+
+  // Motion, a button press, more motion and the end of the frame, as input_system dispatches them.
+  di::mouse_motion_coalescer coalescer;
+  coalescer.add(1, 0          , {10, 10}, { 1,  2});
+  coalescer.add(2, 0          , {50, 50}, { 5,  5});
+  coalescer.add(1, 0          , {13, 11}, { 3,  1});
+  coalescer.add(1, touch_mouse, {90, 90}, {40, 40});
+  coalescer.add(1, 0          , {12, 15}, {-1,  4});
+  coalescer.flush(record);
+  dispatched.push_back("press");
+  REQUIRE(coalescer.empty());
+  coalescer.add(1, 0          , {20, 20}, { 8,  5});
+  coalescer.add(1, 0          , {21, 22}, { 1,  2});
+  coalescer.flush(record);
+
+  REQUIRE(dispatched == std::vector<std::string>({
+    "1/0 at 12,15 by 3,7",
+    "2/0 at 50,50 by 5,5",
+    "1/4294967295 at 90,90 by 40,40",
+    "press",
+    "1/0 at 21,22 by 9,7"}));
+  coalescer.flush(record);
+  REQUIRE(dispatched.size() == 5);
+}
+
+TEST_CASE("Motion sampler collects mouse and axis motion into contiguous samples.", "[engine]") {
+  const auto mouse_motion = [ ] (const Uint32 timestamp, const Uint32 mouse, const Sint32 x, const Sint32 y)
+  {
+    SDL_Event event {};
+    event.motion.type      = SDL_MOUSEMOTION;
+    event.motion.timestamp = timestamp;
+    event.motion.which     = mouse;
+    event.motion.xrel      = x;
+    event.motion.yrel      = y;
+    return event;
+  };
+  const auto axis_motion  = [ ] (const Uint32 timestamp, const Sint32 joystick, const Uint8 axis, const Sint16 value)
+  {
+    SDL_Event event {};
+    event.jaxis.type      = SDL_JOYAXISMOTION;
+    event.jaxis.timestamp = timestamp;
+    event.jaxis.which     = joystick;
+    event.jaxis.axis      = axis;
+    event.jaxis.value     = value;
+    return event;
+  };
+  SDL_Event key_down {};
+  key_down.type = SDL_KEYDOWN;
+
+  const std::vector<SDL_Event> events {mouse_motion(10, 1, 3, -2), axis_motion(11, 4, 2, -32768), key_down, mouse_motion(12, 2, -7, 5), axis_motion(13, 4, 0, 16384)};
+
+  di::motion_sampler sampler;
+  sampler.record(events);
+  const auto mouse = sampler.mouse_motion_samples();
+  const auto axes  = sampler.axis_motion_samples ();
+  REQUIRE(mouse.size() == 2);
+  REQUIRE(mouse[0].timestamp == 10);
+  REQUIRE(mouse[0].device    == 1);
+  REQUIRE(mouse[0].delta     == (std::array<std::int32_t, 2>{3, -2}));
+  REQUIRE(mouse[1].timestamp == 12);
+  REQUIRE(mouse[1].device    == 2);
+  REQUIRE(mouse[1].delta     == (std::array<std::int32_t, 2>{-7, 5}));
+  REQUIRE(axes.size() == 2);
+  REQUIRE(axes[0].timestamp == 11);
+  REQUIRE(axes[0].device    == 4);
+  REQUIRE(axes[0].axis      == 2);
+  REQUIRE(axes[0].value     == -1.0F);
+  REQUIRE(axes[1].timestamp == 13);
+  REQUIRE(axes[1].device    == 4);
+  REQUIRE(axes[1].axis      == 0);
+  REQUIRE(axes[1].value     == 0.5F);
+
+  // Each record overwrites the samples of the previous one.
+  sampler.record(di::span<const SDL_Event>(events.data(), 1));
+  REQUIRE(sampler.mouse_motion_samples().size() == 1);
+  REQUIRE(sampler.axis_motion_samples ().empty());
+}
+
+TEST_CASE("Instance router routes each instance id to all of its devices.", "[engine]") {
+  struct device { int name; };
+  device first {1}, second {2}, third {3}, invalid {4};
+
+  di::instance_router<device> router;
+  router.add(0 , &first  );
+  router.add(2 , &second );
+  router.add(2 , &third  ); // The same joystick opened twice.
+  router.add(-1, &invalid);
+
+  const auto routed = [&router] (const std::int32_t instance_id)
+  {
+    std::vector<int> names;
+    router.route(instance_id, [&names] (device* device) { names.push_back(device->name); });
+    return names;
+  };
+  REQUIRE(routed(0 ) == (std::vector<int> {1}));
+  REQUIRE(routed(1 ).empty());
+  REQUIRE(routed(2 ) == (std::vector<int> {2, 3}));
+  REQUIRE(routed(-1).empty());
+  REQUIRE(routed(64).empty());
+
+  router.remove(&third); // Leaves the other device of the instance routed.
+  REQUIRE(routed(2) == (std::vector<int> {2}));
+
+  // Devices may be removed while routed, e.g. when closed on removal of the joystick.
+  router.add(2, &third);
+  std::vector<int> closed;
+  router.route(2, [&] (device* device) { closed.push_back(device->name); router.remove(device); });
+  REQUIRE(closed == (std::vector<int> {2, 3}));
+  REQUIRE(routed(2).empty());
+  REQUIRE(routed(0) == (std::vector<int> {1}));
+}
@@ -0,0 +1,46 @@
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+
+#include <boost/signals2.hpp>
+
+#include <di/utility/signal.hpp>
+
+// Compares the emission cost of boost::signals2::signal and di::signal under both policies, for as many slots as an input signal usually has.
+constexpr std::size_t emission_count = 1000000;
+volatile  std::size_t sink           = 0;
+
+template<typename signal_type>
+double measure(const std::size_t slot_count)
+{
+  signal_type signal;
+  std::size_t sum = 0;
+  for (std::size_t i = 0; i < slot_count; ++i)
+    signal.connect([&sum] (const std::size_t value) { sum += value; });
+
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < emission_count; ++i)
+    signal(i);
+  const auto time  = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / emission_count;
+  sink = sum; // Keeps the slots from being optimized out.
+  return time;
+}
+
+void benchmark(const std::size_t slot_count)
+{
+  const auto boost_time          = measure<boost::signals2::signal<void(std::size_t)>>                     (slot_count);
+  const auto synchronized_time   = measure<di::signal<void(std::size_t), di::synchronized_signal_policy>>  (slot_count);
+  const auto unsynchronized_time = measure<di::signal<void(std::size_t), di::unsynchronized_signal_policy>>(slot_count);
+  std::cout << std::setw(4) << slot_count << " slots | boost::signals2: " << std::setw(8) << boost_time << " ns/emission | di::signal: " << std::setw(8) << synchronized_time << " ns/emission | di::signal (unsynchronized): " << std::setw(8) << unsynchronized_time << " ns/emission\n";
+}
+
+int main()
+{
+  std::cout << std::fixed << std::setprecision(1);
+  benchmark(0);
+  benchmark(1);
+  benchmark(4);
+  benchmark(16);
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+
+#include <di/engine.hpp>
+#include <di/static_engine.hpp>
+
+// Compares the per-frame dispatch overhead of engine and static_engine. Each system overrides tick only, as most systems override one or two hooks.
+constexpr std::size_t frame_count = 100000;
+
+template<std::size_t index>
+struct benchmark_system : di::system
+{
+  void tick() override
+  {
+    ++ticks;
+  }
+  std::size_t ticks = 0;
+};
+struct frame_counter    : di::system
+{
+  void post_tick() override
+  {
+    if (++frames == frame_count) stop_engine();
+  }
+  std::size_t frames = 0;
+};
+
+template<std::size_t... indices>
+double measure_engine       (std::index_sequence<indices...>)
+{
+  di::engine engine;
+  (engine.add_system<benchmark_system<indices>>(), ...);
+  engine.add_system<frame_counter>();
+
+  const auto start = std::chrono::steady_clock::now();
+  engine.run();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frame_count;
+}
+template<std::size_t... indices>
+double measure_static_engine(std::index_sequence<indices...>)
+{
+  di::static_engine<benchmark_system<indices>..., frame_counter> engine;
+
+  const auto start = std::chrono::steady_clock::now();
+  engine.run();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frame_count;
+}
+
+template<std::size_t system_count>
+void benchmark()
+{
+  const auto dynamic_time = measure_engine       (std::make_index_sequence<system_count>());
+  const auto static_time  = measure_static_engine(std::make_index_sequence<system_count>());
+  std::cout << std::setw(4) << system_count << " systems | engine: " << std::setw(10) << dynamic_time << " ns/frame | static_engine: " << std::setw(10) << static_time << " ns/frame\n";
+}
+
+int main()
+{
+  std::cout << std::fixed << std::setprecision(1);
+  benchmark<2  >();
+  benchmark<16 >();
+  benchmark<128>();
+  return 0;
+}
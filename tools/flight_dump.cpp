@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <di/utility/flight_recorder.hpp>
+
+// Prints a flight recorder dump: the frame times around the hitch, then each channel of the hitch frame against its median over the dump.
+// Usage: flight_dump <file.difr> [--all], where --all also prints the non-zero channels of every frame.
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " <file.difr> [--all]\n";
+    return 1;
+  }
+
+  di::flight_recorder::dump dump;
+  try
+  {
+    std::ifstream stream(argv[1], std::ios::binary);
+    if (!stream)
+      throw std::runtime_error(std::string("Failed to open ") + argv[1] + ".");
+    dump = di::flight_recorder::read(stream);
+  }
+  catch (const std::exception& exception)
+  {
+    std::cerr << exception.what() << "\n";
+    return 1;
+  }
+  const auto all = argc > 2 && std::string(argv[2]) == "--all";
+
+  std::cout << "Hitch at frame " << dump.hitch_frame << " (threshold " << dump.threshold << " ms), " << dump.frames.size() << " frames, "
+            << dump.channels.size() << " channels.\n\n" << std::fixed << std::setprecision(3);
+
+  std::size_t hitch = 0;
+  for (std::size_t frame = 0; frame < dump.frames.size(); ++frame)
+  {
+    const auto time = dump.value(frame, di::flight_recorder::frame_time_channel);
+    if (dump.frames[frame] == dump.hitch_frame)
+      hitch = frame;
+    std::cout << (dump.frames[frame] == dump.hitch_frame ? "* " : "  ") << std::setw(10) << dump.frames[frame] << std::setw(12) << time << " ms"
+              << (time > dump.threshold ? "  slow" : "") << "\n";
+    if (all)
+      for (std::size_t channel = 1; channel < dump.channels.size(); ++channel)
+        if (dump.value(frame, channel) != 0.0)
+          std::cout << "      " << std::left << std::setw(48) << dump.channels[channel] << std::right << std::setw(14) << dump.value(frame, channel) << "\n";
+  }
+  if (dump.frames.empty())
+    return 0;
+
+  std::cout << "\n" << std::left << std::setw(48) << "channel" << std::right << std::setw(14) << "hitch" << std::setw(14) << "median" << "\n";
+  for (std::size_t channel = 0; channel < dump.channels.size(); ++channel)
+  {
+    std::vector<double> values(dump.frames.size());
+    for (std::size_t frame = 0; frame < dump.frames.size(); ++frame)
+      values[frame] = dump.value(frame, channel);
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    const auto median = values[values.size() / 2];
+    const auto value  = dump.value(hitch, channel);
+    if (value != 0.0 || median != 0.0)
+      std::cout << std::left << std::setw(48) << dump.channels[channel] << std::right << std::setw(14) << value << std::setw(14) << median << "\n";
+  }
+  return 0;
+}